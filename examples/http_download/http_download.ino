@@ -0,0 +1,104 @@
+/**
+ * @brief This example demonstrates a resumable download of a file larger than
+ * what fits in RAM with HttpDownload. The file is fetched in blocks with range
+ * requests and verified with CRC-32 and SHA-256 (calculated on the ECC). If
+ * the download is interrupted, it continues from the last completed block.
+ */
+#include <Arduino.h>
+#include <ecc608.h>
+#include <http_client.h>
+#include <http_download.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+
+#define DOMAIN    "httpbin.org"
+#define ENDPOINT  "/range/40960"
+#define FILE_SIZE (40960UL)
+
+#define MAX_RESUMES (3)
+
+// SHA-256 and CRC-32 of the file served at ENDPOINT, which is the alphabet
+// repeated
+const uint8_t FILE_SHA256[32] PROGMEM = {
+    0xd5, 0x01, 0xf6, 0x51, 0xea, 0xa8, 0x3c, 0xd6, 0x89, 0x96, 0xe6,
+    0xaf, 0x7c, 0x63, 0x9b, 0x26, 0x51, 0x69, 0x3b, 0xb7, 0x30, 0xf1,
+    0x85, 0xd4, 0x98, 0x25, 0xd8, 0x52, 0x83, 0xdf, 0xb0, 0xa7};
+
+#define FILE_CRC32 (0xDB0C89C1UL)
+
+static void onData(__attribute__((unused)) const uint8_t* data,
+                   __attribute__((unused)) const uint16_t length,
+                   __attribute__((unused)) const uint32_t offset) {
+
+    // A real application would e.g. write the data to flash at offset here
+}
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting HTTP download example"));
+
+    if (ECC608.begin() != ATCA_SUCCESS) {
+        Log.error(F("Failed to initialize the ECC"));
+        return;
+    }
+
+    // Start modem and connect to the operator
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    if (!HttpClient.configure(DOMAIN, 80, false)) {
+        Log.info(F("Failed to configure http client\r\n"));
+        return;
+    }
+
+    HttpDownloadImage image = {};
+    image.size              = FILE_SIZE;
+    image.verify_crc32      = true;
+    image.crc32             = FILE_CRC32;
+    image.verify_sha256     = true;
+    memcpy_P(image.sha256, FILE_SHA256, sizeof(image.sha256));
+
+    // Always start from scratch, so that the example downloads the whole file
+    HttpDownload.clearProgress();
+
+    const uint32_t start_ms = millis();
+    HttpDownloadResult result;
+
+    for (uint8_t i = 0; i <= MAX_RESUMES; i++) {
+        result = HttpDownload.download(ENDPOINT, image, onData);
+
+        if (result != HttpDownloadResult::INTERRUPTED) {
+            break;
+        }
+
+        Log.warnf(F("Download interrupted at %lu bytes\r\n"),
+                  HttpDownload.getProgress(ENDPOINT, image));
+
+        if (!Lte.isConnected() && !Lte.begin()) {
+            Log.error(F("Failed to reconnect to the operator"));
+            return;
+        }
+    }
+
+    if (result != HttpDownloadResult::OK) {
+        Log.errorf(F("Failed to download the file, result: %d\r\n"),
+                   static_cast<int>(result));
+        return;
+    }
+
+    Log.infof(F("Downloaded and verified %lu bytes in %lu ms, "
+                "CRC-32 %08lX\r\n"),
+              image.size,
+              millis() - start_ms,
+              HttpDownload.getCrc32());
+}
+
+void loop() {}
@@ -1,6 +1,7 @@
 /**
  * @brief This example demonstrates how to retrieve the unix time from a NTP
- * server.
+ * server, and compares it with the network time which is kept on the device
+ * after connecting to the operator.
  */
 
 #include <Arduino.h>
@@ -8,6 +9,7 @@
 #include <led_ctrl.h>
 #include <log.h>
 #include <lte.h>
+#include <network_time.h>
 
 #define TIMEZONE_URL "worldtimeapi.org"
 #define TIMEZONE_URI "/api/timezone/Europe/Oslo.txt"
@@ -36,6 +38,12 @@ void setup() {
 
     Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
 
+    // The network time is anchored when connecting, so this doesn't require a
+    // command to the modem
+    const uint32_t network_time = NetworkTime.now();
+
+    Log.infof(F("Got the network time (unixtime) %lu\r\n"), network_time);
+
     if (!HttpClient.configure(TIMEZONE_URL, 80, false)) {
         Log.errorf(F("Failed to configure HTTP for the domain %s\r\n"),
                    TIMEZONE_URL);
@@ -71,7 +79,11 @@ void setup() {
         return;
     }
 
-    Log.infof(F("Got the time (unixtime) %lu\r\n"), getTimeFromResponse(&body));
+    const long server_time = getTimeFromResponse(&body);
+
+    Log.infof(F("Got the time (unixtime) %lu\r\n"), server_time);
+    Log.infof(F("The network time differs by %ld seconds\r\n"),
+              (long)(NetworkTime.now() - (uint32_t)server_time));
 }
 
 void loop() {}
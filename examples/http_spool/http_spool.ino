@@ -0,0 +1,83 @@
+/**
+ * @brief This example demonstrates batching small records, e.g. sensor
+ * samples, with HttpSpool, so that they are sent together in one POST instead
+ * of one request per record.
+ */
+#include <Arduino.h>
+#include <http_client.h>
+#include <http_spool.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+
+#define DOMAIN   "httpbin.org"
+#define ENDPOINT "/post"
+
+// Every record is 20 bytes including the newline, so the spool is flushed for
+// every seventh record
+#define FLUSH_SIZE (128)
+
+#define SAMPLE_INTERVAL_MS (1000)
+#define NUMBER_OF_SAMPLES  (21)
+
+static bool spool_ready        = false;
+static uint8_t samples         = 0;
+static uint32_t last_sample_ms = 0;
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting HTTP spool example"));
+
+    // Start modem and connect to the operator
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    if (!HttpClient.configure(DOMAIN, 80, false)) {
+        Log.info(F("Failed to configure http client\r\n"));
+        return;
+    }
+
+    // Only flush on the amount of spooled bytes, not the age of the records
+    spool_ready = HttpSpool.begin(ENDPOINT,
+                                  HttpSpoolFormat::NEWLINE_DELIMITED,
+                                  FLUSH_SIZE,
+                                  0);
+}
+
+void loop() {
+
+    if (!spool_ready || samples >= NUMBER_OF_SAMPLES ||
+        millis() - last_sample_ms < SAMPLE_INTERVAL_MS) {
+        return;
+    }
+
+    last_sample_ms = millis();
+
+    char record[20];
+    snprintf(record,
+             sizeof(record),
+             "sample=%02u,value=%03u",
+             samples,
+             (unsigned int)(millis() % 1000));
+    samples++;
+
+    HttpSpool.append(record);
+
+    const uint16_t pending = HttpSpool.getPendingRecords();
+
+    if (!HttpSpool.poll()) {
+        Log.errorf(F("Failed to post the records, status code: %u\r\n"),
+                   HttpSpool.getLastStatusCode());
+    } else if (HttpSpool.getPendingRecords() == 0) {
+        Log.infof(F("Posted %u records in one request, status code: %u\r\n"),
+                  pending,
+                  HttpSpool.getLastStatusCode());
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @brief This example demonstrates downloading a HTTP body larger than what
+ * fits in a single read by streaming it in chunks, and measures the download
+ * throughput. Point DOMAIN and ENDPOINT to a local HTTP server to measure
+ * without the latency of the internet.
+ */
+#include <Arduino.h>
+#include <http_client.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+
+#define DOMAIN   "httpbin.org"
+#define ENDPOINT "/bytes/8192"
+
+static uint32_t checksum = 0;
+
+static void onChunk(const uint8_t* chunk,
+                    const uint16_t chunk_length,
+                    __attribute__((unused)) const uint32_t offset) {
+
+    // A real application would e.g. write the chunk to flash here
+    for (uint16_t i = 0; i < chunk_length; i++) { checksum += chunk[i]; }
+}
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting HTTP stream download example"));
+
+    // Start modem and connect to the operator
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    if (!HttpClient.configure(DOMAIN, 80, false)) {
+        Log.info(F("Failed to configure http client\r\n"));
+        return;
+    }
+
+    const uint32_t request_start_ms = millis();
+    const HttpResponse response     = HttpClient.get(ENDPOINT);
+
+    Log.infof(F("GET - HTTP status code: %u, data size: %lu\r\n"),
+              response.status_code,
+              response.data_size);
+
+    if (response.status_code != HttpClient.STATUS_OK) {
+        return;
+    }
+
+    const uint32_t download_start_ms = millis();
+
+    const uint32_t bytes_read = HttpClient.streamBody(response.data_size,
+                                                      onChunk);
+
+    const uint32_t download_ms = max(millis() - download_start_ms, 1UL);
+
+    Log.infof(F("Downloaded %lu bytes in %lu ms (request %lu ms), %lu B/s, "
+                "checksum %lu\r\n"),
+              bytes_read,
+              download_ms,
+              download_start_ms - request_start_ms,
+              (bytes_read * 1000UL) / download_ms,
+              checksum);
+}
+
+void loop() {}
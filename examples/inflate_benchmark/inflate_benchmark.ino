@@ -0,0 +1,217 @@
+/**
+ * This example measures the speed and RAM usage of the decoder used by
+ * HttpClient.streamInflatedBody() for compressed HTTP bodies. It decodes a
+ * gzip compressed configuration manifest stored in flash, so no network is
+ * needed, with each of the window sizes in the sweep.
+ *
+ * The manifest was compressed with a 512 byte window (zlib's windowBits 9), so
+ * that it can be decoded with all the windows in the sweep. The peak RAM is
+ * measured by painting the free memory before decoding and includes the
+ * window, the Huffman tables and the stack used by the decoder.
+ *
+ * The results are printed as comma separated lines starting with BENCH, so
+ * that they can be collected and compared between runs.
+ */
+
+#include <Arduino.h>
+
+#include <inflate.h>
+#include <led_ctrl.h>
+#include <log.h>
+
+#define ITERATIONS (10)
+
+// The window is allocated on the stack, larger windows don't fit in RAM
+#define MIN_WINDOW_BITS (9)
+#define MAX_WINDOW_BITS (12)
+
+#define STACK_PAINT       (0xA5)
+#define STACK_PAINT_GUARD (32)
+
+#define MANIFEST_SIZE (6439)
+
+extern char __heap_start;
+extern char* __brkval;
+
+const uint8_t compressed_manifest[] PROGMEM = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0xCF,
+    0x4D, 0x6A, 0x5C, 0x49, 0x10, 0x85, 0xD1, 0xBD, 0xBC, 0xB1, 0x08, 0xE2,
+    0x3F, 0x33, 0xB5, 0x95, 0xA6, 0x07, 0x32, 0x2E, 0x63, 0x83, 0x5C, 0x82,
+    0x2A, 0xB5, 0x27, 0x46, 0x7B, 0x6F, 0x81, 0x47, 0xE9, 0x9B, 0x2F, 0x8B,
+    0x98, 0x46, 0xC0, 0xE1, 0x7E, 0xBF, 0x8F, 0x5F, 0x97, 0xDB, 0xFD, 0xC7,
+    0xDB, 0xF5, 0x78, 0x3E, 0x84, 0x9C, 0xF4, 0x78, 0x3A, 0xEE, 0x97, 0xEB,
+    0xFD, 0xED, 0x76, 0x3F, 0x9E, 0xFF, 0xF9, 0x7D, 0x5C, 0x5F, 0x7E, 0x5E,
+    0x3E, 0x5F, 0x7F, 0x4E, 0xFC, 0xF9, 0xFC, 0x71, 0x7D, 0xBF, 0xDC, 0x7E,
+    0xBD, 0xBC, 0x1E, 0xCF, 0xC9, 0x4F, 0xC7, 0xE5, 0xFA, 0xF2, 0xE5, 0xF5,
+    0xF2, 0xF5, 0x78, 0x7E, 0xBF, 0xFD, 0x77, 0x79, 0x3A, 0xDE, 0xBF, 0xDF,
+    0x2E, 0xF7, 0xEF, 0x6F, 0xAF, 0x9F, 0x87, 0xE1, 0xD4, 0x3F, 0x9E, 0xFE,
+    0x02, 0xE4, 0x1C, 0xF8, 0xF6, 0xF2, 0x7A, 0x9F, 0x85, 0x0C, 0x12, 0x10,
+    0x74, 0x12, 0x64, 0x2F, 0x74, 0x5D, 0x08, 0x76, 0x2E, 0x40, 0x84, 0x25,
+    0x25, 0x00, 0x5E, 0x99, 0x30, 0x84, 0x18, 0x84, 0xA8, 0x08, 0x46, 0x0D,
+    0x80, 0x9C, 0x80, 0xDC, 0x36, 0xB8, 0x50, 0x07, 0xA0, 0x95, 0x1A, 0x48,
+    0x00, 0xE8, 0xE7, 0x0B, 0x10, 0x08, 0x1A, 0x00, 0x8C, 0x09, 0x30, 0xDE,
+    0x36, 0x88, 0x92, 0x83, 0x20, 0x5C, 0x89, 0x48, 0x5B, 0x54, 0x88, 0x6C,
+    0x56, 0xA0, 0x31, 0x9C, 0x3A, 0x1A, 0x5A, 0x29, 0x89, 0x4E, 0x89, 0x84,
+    0x55, 0x4A, 0x46, 0x5B, 0x11, 0x5E, 0x21, 0x22, 0xA8, 0x21, 0x11, 0xE7,
+    0x04, 0x74, 0xE8, 0x20, 0x46, 0x21, 0x4B, 0x23, 0x9C, 0x04, 0x89, 0x36,
+    0x11, 0xC6, 0x7B, 0xC3, 0x98, 0x3A, 0x1A, 0x7D, 0x63, 0x40, 0x89, 0xF4,
+    0xD5, 0x8C, 0x51, 0x9A, 0x11, 0x6D, 0x61, 0x28, 0x4F, 0x86, 0x3C, 0x28,
+    0x69, 0xA4, 0x48, 0x48, 0xA5, 0xA4, 0xC9, 0x8A, 0xD0, 0x52, 0x49, 0x12,
+    0x23, 0x61, 0x95, 0x10, 0x1F, 0x94, 0x48, 0x78, 0x25, 0xC4, 0x95, 0x3A,
+    0x12, 0x31, 0x11, 0xF9, 0x60, 0x45, 0xAE, 0x56, 0x64, 0x85, 0xB0, 0x24,
+    0x45, 0xA2, 0x4D, 0x84, 0x6C, 0x3B, 0xDA, 0x20, 0x47, 0xA1, 0x4F, 0x82,
+    0xF1, 0x7E, 0x45, 0xEB, 0xC4, 0x68, 0x8C, 0xF3, 0x15, 0x48, 0x44, 0x5B,
+    0xCC, 0x30, 0xDE, 0xCC, 0x80, 0x12, 0x1F, 0x14, 0x48, 0xC8, 0x44, 0xE4,
+    0x83, 0x10, 0xA5, 0x81, 0x84, 0x56, 0x88, 0xE4, 0x15, 0x61, 0x13, 0x21,
+    0xDB, 0x0E, 0x11, 0xEA, 0x28, 0x78, 0x65, 0x84, 0x24, 0x05, 0x12, 0x51,
+    0x22, 0x82, 0x14, 0x89, 0x3C, 0x27, 0xA0, 0xC3, 0x75, 0x25, 0xB4, 0x49,
+    0x30, 0xDE, 0xAF, 0x68, 0xD4, 0x91, 0xE8, 0x25, 0x22, 0x1A, 0x19, 0x1A,
+    0xA3, 0x10, 0x62, 0x4E, 0x0C, 0x82, 0xF3, 0xB9, 0xB0, 0x18, 0x31, 0xC8,
+    0x91, 0x90, 0x52, 0x48, 0x1B, 0xD4, 0xD0, 0xD0, 0xC9, 0x90, 0x6D, 0x48,
+    0x5F, 0x86, 0x58, 0x25, 0xC4, 0xDB, 0x2A, 0xC4, 0x4B, 0x21, 0x49, 0x81,
+    0x44, 0x6C, 0x08, 0x08, 0x69, 0x4C, 0x82, 0x44, 0x96, 0x56, 0x44, 0xA3,
+    0x8E, 0x46, 0x2B, 0x19, 0x5D, 0x49, 0xD1, 0xE8, 0x93, 0x91, 0xFB, 0x12,
+    0xA1, 0x86, 0xC2, 0x28, 0xAD, 0x30, 0x5F, 0x18, 0xC1, 0xE7, 0x2B, 0x16,
+    0x44, 0x50, 0x20, 0x21, 0x9B, 0x19, 0x50, 0x22, 0xAB, 0x92, 0xD0, 0x89,
+    0x90, 0xFD, 0x0A, 0x15, 0xEA, 0x48, 0x58, 0x25, 0x44, 0x94, 0x06, 0x12,
+    0x7E, 0xBE, 0x02, 0x3A, 0x6C, 0xAC, 0x46, 0x44, 0x65, 0x44, 0x27, 0x41,
+    0x21, 0x2B, 0x82, 0x33, 0x29, 0x12, 0xED, 0x9C, 0x80, 0x8C, 0xDE, 0xC9,
+    0x50, 0xE8, 0xA5, 0x8C, 0x24, 0x47, 0x62, 0x54, 0x88, 0xC6, 0x94, 0x40,
+    0x24, 0x17, 0x3A, 0x72, 0xD5, 0x91, 0x52, 0x19, 0x31, 0x82, 0x3A, 0x12,
+    0x3A, 0x11, 0xB2, 0x27, 0x96, 0x23, 0xEC, 0x5C, 0x80, 0x0C, 0x35, 0x52,
+    0x14, 0xBC, 0xB2, 0x41, 0x56, 0x42, 0x4C, 0x82, 0xF1, 0x03, 0xA2, 0xAF,
+    0x8C, 0x9C, 0x8C, 0xDC, 0x76, 0x30, 0x39, 0x02, 0xED, 0x1C, 0xC0, 0x0D,
+    0x61, 0x14, 0x48, 0xF4, 0x52, 0x47, 0x24, 0x25, 0x1A, 0x63, 0x32, 0x64,
+    0xDB, 0x91, 0x83, 0x18, 0x84, 0xC6, 0xA5, 0x15, 0x23, 0x56, 0x86, 0x94,
+    0x8C, 0x6C, 0x8B, 0x92, 0xA6, 0x85, 0x12, 0x0F, 0x6A, 0x28, 0x58, 0x69,
+    0x45, 0x1B, 0xD4, 0xD1, 0xF0, 0xC9, 0xC8, 0x3D, 0x61, 0x4B, 0x22, 0xCE,
+    0x09, 0x08, 0x11, 0x26, 0x47, 0x21, 0x4B, 0x21, 0xCE, 0xC4, 0x68, 0xB4,
+    0xC9, 0x90, 0x3D, 0x91, 0xD4, 0x50, 0xE8, 0xE7, 0x02, 0x74, 0xB8, 0x93,
+    0xA0, 0x30, 0x2A, 0x1B, 0xCC, 0x17, 0x19, 0x9D, 0x2B, 0x84, 0x30, 0x29,
+    0x12, 0x32, 0x11, 0xC6, 0xDB, 0x10, 0x89, 0x45, 0x48, 0xD7, 0xCA, 0x8A,
+    0xE1, 0x34, 0x90, 0xB0, 0xCD, 0x0A, 0x34, 0x94, 0x12, 0x09, 0x3F, 0x5F,
+    0x01, 0x1D, 0x29, 0xE4, 0x28, 0x44, 0xA5, 0x23, 0x6D, 0x45, 0xE4, 0x44,
+    0xE4, 0x03, 0x82, 0x49, 0x91, 0x68, 0xE7, 0x04, 0x74, 0x88, 0x92, 0xA1,
+    0xD0, 0x2B, 0x23, 0xC6, 0x58, 0x11, 0xA3, 0x42, 0x78, 0x27, 0x06, 0x62,
+    0x70, 0xA1, 0xA3, 0x53, 0x22, 0x20, 0x13, 0x20, 0xFB, 0x0D, 0x2D, 0x56,
+    0x1B, 0x74, 0x22, 0x8C, 0xF7, 0x86, 0x26, 0x05, 0x1A, 0xB6, 0x31, 0x20,
+    0x44, 0x92, 0x04, 0x09, 0xAF, 0x94, 0x28, 0xAF, 0x56, 0x44, 0xA9, 0xC4,
+    0x92, 0xF4, 0xE3, 0xDF, 0x8F, 0xFF, 0x01, 0xD2, 0x41, 0x7B, 0x52, 0x27,
+    0x19, 0x00, 0x00};
+
+static uint16_t input_position = 0;
+static uint32_t inflated_size  = 0;
+
+static int16_t readManifestByte(void) {
+    if (input_position >= sizeof(compressed_manifest)) {
+        return -1;
+    }
+
+    return pgm_read_byte(&compressed_manifest[input_position++]);
+}
+
+static void countInflatedBytes(__attribute__((unused)) const uint8_t* data,
+                               const uint16_t length,
+                               __attribute__((unused)) const uint32_t offset) {
+    inflated_size += length;
+}
+
+/**
+ * @brief Fills the free memory between the heap and the stack with a known
+ * pattern, so that the deepest point the stack reached can be found afterwards.
+ */
+static void paintFreeMemory(void) {
+    uint8_t marker;
+    uint8_t* address = (uint8_t*)(__brkval == NULL ? &__heap_start : __brkval);
+
+    while (address < &marker - STACK_PAINT_GUARD) {
+        *address++ = STACK_PAINT;
+    }
+}
+
+/**
+ * @return Bytes of the stack used below @p stack_top since the memory was
+ * painted.
+ */
+static uint16_t peakStackUsage(const uint8_t* stack_top) {
+    const uint8_t* address = (const uint8_t*)(__brkval == NULL ? &__heap_start
+                                                               : __brkval);
+
+    while (*address == STACK_PAINT && address < stack_top) {
+        address++;
+    }
+
+    return stack_top - address;
+}
+
+/**
+ * @brief Decodes the manifest once. Kept out of line so that the window is
+ * allocated on the stack measured.
+ */
+static __attribute__((noinline)) InflateResult
+inflateManifest(const uint8_t window_bits) {
+    uint8_t window[1U << window_bits];
+    Inflater inflater(window, window_bits);
+
+    input_position = 0;
+    inflated_size  = 0;
+
+    return inflater.inflate(readManifestByte, countInflatedBytes);
+}
+
+static void runBenchmark(const uint8_t window_bits) {
+
+    uint8_t stack_top;
+    paintFreeMemory();
+
+    const uint32_t start_ms = millis();
+    uint8_t completed       = 0;
+
+    for (uint8_t i = 0; i < ITERATIONS; i++) {
+        if (inflateManifest(window_bits) != InflateResult::OK ||
+            inflated_size != MANIFEST_SIZE) {
+            Log.errorf(F("Failed to inflate the manifest with window bits "
+                         "%u\r\n"),
+                       window_bits);
+            break;
+        }
+
+        completed++;
+    }
+
+    const uint32_t duration_ms = max(millis() - start_ms, 1UL);
+
+    // Decompressed kB per second with two decimals
+    const uint32_t rate = ((uint32_t)MANIFEST_SIZE * completed * 100UL) /
+                          duration_ms * 1000UL / 1024UL;
+
+    Log.rawf(F("BENCH,%u,%u,%u,%u,%lu,%lu.%02lu,%u\r\n"),
+             window_bits,
+             (uint16_t)sizeof(compressed_manifest),
+             (uint16_t)MANIFEST_SIZE,
+             completed,
+             completed > 0 ? duration_ms / completed : 0,
+             rate / 100,
+             rate % 100,
+             peakStackUsage(&stack_top));
+}
+
+void setup() {
+    Log.begin(115200);
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.info(F("Starting inflate benchmark"));
+
+    Log.rawf(F("BENCH,window_bits,compressed_size,inflated_size,count,"
+               "ms_per_inflate,inflated_kb_per_s,peak_ram_bytes\r\n"));
+
+    for (uint8_t window_bits = MIN_WINDOW_BITS; window_bits <= MAX_WINDOW_BITS;
+         window_bits++) {
+        runBenchmark(window_bits);
+    }
+
+    Log.info(F("Benchmark done"));
+}
+
+void loop() {}
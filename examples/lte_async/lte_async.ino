@@ -0,0 +1,91 @@
+/**
+ * @brief This example demonstrates connecting to the operator without blocking
+ * with Lte.beginAsync() and Lte.poll(), so that the application can do other
+ * work whilst the modem searches for the network.
+ */
+#include <Arduino.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+
+static uint32_t start_ms = 0;
+
+/**
+ * @brief Counts the iterations of the loop whilst connecting, as a stand-in
+ * for other work done by the application.
+ */
+static uint32_t loop_iterations = 0;
+
+static bool connecting = false;
+
+static const char* stateToString(const LteState state) {
+    switch (state) {
+    case LteState::OFF:
+        return "OFF";
+    case LteState::SIM_CHECK:
+        return "SIM_CHECK";
+    case LteState::REGISTERING:
+        return "REGISTERING";
+    case LteState::TIME_SYNC:
+        return "TIME_SYNC";
+    case LteState::CONNECTED:
+        return "CONNECTED";
+    case LteState::LOST:
+        return "LOST";
+    case LteState::FAILED:
+        return "FAILED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+static void onStateChange(const LteState state) {
+    Log.infof(F("LTE state: %s\r\n"), stateToString(state));
+}
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting LTE async example"));
+
+    Lte.onStateChange(onStateChange);
+
+    start_ms = millis();
+
+    // Returns as soon as the modem has been started, the connection is then
+    // driven by Lte.poll() in the loop
+    if (!Lte.beginAsync()) {
+        Log.error(F("Failed to start the modem"));
+        return;
+    }
+
+    connecting = true;
+}
+
+void loop() {
+
+    if (!connecting) {
+        return;
+    }
+
+    const LteState state = Lte.poll();
+
+    if (state == LteState::CONNECTED) {
+        connecting = false;
+
+        Log.infof(F("Connected to operator: %s\r\n"),
+                  Lte.getOperator().c_str());
+        Log.infof(F("Connected after %lu ms, the loop ran %lu times whilst "
+                    "connecting\r\n"),
+                  millis() - start_ms,
+                  loop_iterations);
+    } else if (state == LteState::FAILED) {
+        connecting = false;
+
+        Log.error(F("Failed to connect to the operator"));
+    } else {
+        loop_iterations++;
+    }
+}
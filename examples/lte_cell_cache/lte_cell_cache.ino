@@ -0,0 +1,64 @@
+/**
+ * @brief This example demonstrates caching the last known cell with
+ * Lte.enableCellCache(), so that the next attach only searches the band of
+ * that cell. The modem is shut down and connected again, and the time of both
+ * attaches is printed.
+ */
+#include <Arduino.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting LTE cell cache example"));
+
+    Lte.enableCellCache();
+
+    // Start without a cached cell, so that the first attach searches all the
+    // bands
+    Lte.clearCellCache();
+
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    LteCellInfo cell;
+
+    if (!Lte.getCachedCell(&cell)) {
+        Log.error(F("The cell was not cached"));
+        return;
+    }
+
+    Log.infof(F("Cached cell on PLMN %s, band %u, EARFCN %lu\r\n"),
+              cell.plmn,
+              cell.band,
+              cell.earfcn);
+
+    Lte.end();
+
+    // The modem has forgotten the network now, so this attaches again, but
+    // only searches the band of the cached cell
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    const LteAttachStatistics statistics = Lte.getAttachStatistics();
+
+    Log.infof(F("Attaches: %u, cached: %u, fallbacks: %u\r\n"),
+              statistics.attaches,
+              statistics.cached_attaches,
+              statistics.fallbacks);
+    Log.infof(F("Full scan attach took %lu ms, cached attach took %lu ms\r\n"),
+              statistics.full_scan_attach_total_ms,
+              statistics.cached_attach_total_ms);
+}
+
+void loop() {}
@@ -0,0 +1,61 @@
+/**
+ * @brief This example demonstrates sampling the signal quality of the serving
+ * cell with LteSignal, and using it to tell whether it is a good time to
+ * transmit.
+ */
+#include <Arduino.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+#include <lte_signal.h>
+
+#define SAMPLE_INTERVAL_MS (5000)
+#define NUMBER_OF_SAMPLES  (5)
+
+static bool connected  = false;
+static uint8_t samples = 0;
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting LTE signal example"));
+
+    // Start modem and connect to the operator
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    connected = true;
+}
+
+void loop() {
+
+    if (!connected || samples >= NUMBER_OF_SAMPLES ||
+        !LteSignal.poll(SAMPLE_INTERVAL_MS)) {
+        return;
+    }
+
+    samples++;
+
+    LteSignalSample sample;
+    LteSignal.getLatest(&sample);
+
+    Log.infof(F("RSRP: %d dBm, RSRQ: %d dB, SINR: %d dB, cell ID: %lu\r\n"),
+              sample.rsrp,
+              sample.rsrq,
+              sample.sinr,
+              sample.cell_id);
+
+    if (samples == NUMBER_OF_SAMPLES) {
+        Log.infof(F("Average RSRP of %u samples: %d dBm, good time to "
+                    "transmit: %s\r\n"),
+                  samples,
+                  LteSignal.getAverageRsrp(),
+                  LteSignal.isGoodTimeToTransmit() ? "yes" : "no");
+    }
+}
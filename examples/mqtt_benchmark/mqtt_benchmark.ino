@@ -0,0 +1,276 @@
+/**
+ * This example measures the MQTT throughput and latency achieved with the
+ * library. It publishes messages to a topic it is subscribed to and measures
+ * the time spent in publish, the round trip until the message notification
+ * reaches the receive handler and the time spent reading the message.
+ *
+ * The sweep covers payload sizes from 16 to 1024 bytes, the three QoS levels
+ * and two receive paths:
+ *
+ * - sync: The message is read directly with streamMessage() when the
+ *   notification arrives.
+ * - async: The message is fetched into the inbound queue with
+ *   fetchMessages() and read with readQueuedMessage(). Payloads which don't
+ *   fit in the inbound queue are skipped.
+ *
+ * The results are printed as comma separated lines starting with BENCH, so
+ * that they can be collected and compared between runs. Point MQTT_BROKER to a
+ * local broker to avoid measuring the latency of the internet.
+ */
+
+#include <Arduino.h>
+
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+#include <mqtt_client.h>
+
+#define MQTT_TOPIC "mchp_benchmark"
+
+#define MQTT_THING_NAME "someuniquemchpbenchmark"
+#define MQTT_BROKER     "test.mosquitto.org"
+#define MQTT_PORT       1883
+#define MQTT_USE_TLS    false
+#define MQTT_USE_ECC    false
+#define MQTT_KEEPALIVE  60
+
+#define ITERATIONS          (10)
+#define RECEIVE_TIMEOUT_MS  (10000)
+#define MAX_PAYLOAD_SIZE    (1024)
+#define INBOUND_HEADER_SIZE (7)
+
+static const uint16_t payload_sizes[] = {16, 64, 256, 1024};
+
+static uint8_t payload[MAX_PAYLOAD_SIZE];
+static uint8_t receive_buffer[MQTT_INBOUND_QUEUE_SIZE];
+static char receive_topic[MQTT_INBOUND_TOPIC_LENGTH];
+
+static volatile bool got_message          = false;
+static volatile int32_t received_id       = -1;
+static volatile uint32_t received_time_ms = 0;
+
+static uint32_t publish_samples[ITERATIONS];
+static uint32_t roundtrip_samples[ITERATIONS];
+static uint32_t read_samples[ITERATIONS];
+
+static void onBenchmarkMessage(__attribute__((unused)) const char* topic,
+                               __attribute__((unused))
+                               const uint16_t message_length,
+                               const int32_t message_id) {
+    received_id      = message_id;
+    received_time_ms = millis();
+    got_message      = true;
+}
+
+static void sortSamples(uint32_t* samples, const uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        const uint32_t value = samples[i];
+        int8_t j             = i - 1;
+
+        while (j >= 0 && samples[j] > value) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+
+        samples[j + 1] = value;
+    }
+}
+
+/**
+ * @brief Returns the sample at the given percentile of the sorted samples.
+ */
+static uint32_t percentile(const uint32_t* samples,
+                           const uint8_t count,
+                           const uint8_t percent) {
+    return samples[((uint16_t)(count - 1) * percent) / 100];
+}
+
+/**
+ * @brief Runs the iterations for one combination of receive path, QoS and
+ * payload size.
+ *
+ * @return The number of iterations which completed.
+ */
+static uint8_t runIterations(const bool async,
+                             const MqttQoS quality_of_service,
+                             const uint16_t payload_size) {
+
+    uint8_t completed = 0;
+
+    for (uint8_t i = 0; i < ITERATIONS; i++) {
+
+        got_message = false;
+
+        const uint32_t publish_start_ms = millis();
+
+        if (!MqttClient.publish(MQTT_TOPIC,
+                                payload,
+                                payload_size,
+                                quality_of_service)) {
+            Log.error(F("Failed to publish"));
+            continue;
+        }
+
+        const uint32_t publish_end_ms = millis();
+        const uint32_t read_start_ms  = publish_end_ms;
+        bool got_payload              = false;
+
+        if (async) {
+            const uint32_t timeout_start_ms = millis();
+
+            while (MqttClient.queuedMessages() == 0 &&
+                   millis() - timeout_start_ms < RECEIVE_TIMEOUT_MS) {
+                MqttClient.fetchMessages();
+            }
+
+            uint16_t message_length = 0;
+
+            got_payload = MqttClient.readQueuedMessage(receive_topic,
+                                                       sizeof(receive_topic),
+                                                       receive_buffer,
+                                                       sizeof(receive_buffer),
+                                                       &message_length) &&
+                          message_length == payload_size;
+
+            // The notification was consumed by the queue, so the round trip
+            // is measured until the message was available
+            received_time_ms = millis();
+        } else {
+            const uint32_t timeout_start_ms = millis();
+
+            while (!got_message &&
+                   millis() - timeout_start_ms < RECEIVE_TIMEOUT_MS) {}
+
+            if (got_message) {
+                uint16_t message_length = 0;
+
+                got_payload = MqttClient.streamMessage(
+                                  MQTT_TOPIC,
+                                  [](const uint8_t*, const uint16_t) {},
+                                  &message_length,
+                                  received_id) == ResponseResult::OK &&
+                              message_length == payload_size;
+            }
+        }
+
+        if (!got_payload) {
+            Log.error(F("Did not receive the published message"));
+            continue;
+        }
+
+        publish_samples[completed]   = publish_end_ms - publish_start_ms;
+        roundtrip_samples[completed] = received_time_ms - publish_start_ms;
+        read_samples[completed]      = millis() - (async ? read_start_ms
+                                                         : received_time_ms);
+        completed++;
+    }
+
+    return completed;
+}
+
+static void runBenchmark(const bool async,
+                         const MqttQoS quality_of_service,
+                         const uint16_t payload_size) {
+
+    MqttClient.enableInboundQueue(async);
+
+    const uint32_t start_ms = millis();
+    const uint8_t completed = runIterations(async,
+                                            quality_of_service,
+                                            payload_size);
+
+    const uint32_t duration_ms = millis() - start_ms;
+
+    if (completed == 0) {
+        Log.rawf(F("BENCH,%s,%u,%u,0,0,0,0,0,0,0\r\n"),
+                 async ? "async" : "sync",
+                 quality_of_service,
+                 payload_size);
+        return;
+    }
+
+    sortSamples(publish_samples, completed);
+    sortSamples(roundtrip_samples, completed);
+    sortSamples(read_samples, completed);
+
+    // Messages per second with two decimals
+    const uint32_t rate = (100000UL * completed) / duration_ms;
+
+    Log.rawf(F("BENCH,%s,%u,%u,%u,%lu.%02lu,%lu,%lu,%lu,%lu,%lu\r\n"),
+             async ? "async" : "sync",
+             quality_of_service,
+             payload_size,
+             completed,
+             rate / 100,
+             rate % 100,
+             percentile(publish_samples, completed, 50),
+             percentile(publish_samples, completed, 90),
+             publish_samples[completed - 1],
+             percentile(roundtrip_samples, completed, 50),
+             percentile(read_samples, completed, 50));
+}
+
+void setup() {
+    Log.begin(115200);
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.info(F("Starting MQTT benchmark"));
+
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to operator"));
+
+        // Halt here
+        while (1) {}
+    }
+
+    if (!MqttClient.begin(MQTT_THING_NAME,
+                          MQTT_BROKER,
+                          MQTT_PORT,
+                          MQTT_USE_TLS,
+                          MQTT_KEEPALIVE,
+                          MQTT_USE_ECC)) {
+        Log.rawf(F("\r\n"));
+        Log.error(F("Failed to connect to broker"));
+
+        // Halt here
+        while (1) {}
+    }
+
+    if (!MqttClient.subscribe(MQTT_TOPIC, EXACTLY_ONCE, onBenchmarkMessage)) {
+        Log.error(F("Failed to subscribe"));
+
+        // Halt here
+        while (1) {}
+    }
+
+    for (uint16_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = 'a' + (i % 26);
+    }
+
+    Log.rawf(F("BENCH,path,qos,size,count,msgs_per_s,publish_p50_ms,"
+               "publish_p90_ms,publish_max_ms,roundtrip_p50_ms,read_p50_ms"
+               "\r\n"));
+
+    for (uint8_t async = 0; async < 2; async++) {
+        for (uint8_t qos = AT_MOST_ONCE; qos <= EXACTLY_ONCE; qos++) {
+            for (uint8_t i = 0; i < sizeof(payload_sizes) / sizeof(uint16_t);
+                 i++) {
+
+                if (async && payload_sizes[i] + INBOUND_HEADER_SIZE >
+                                 MQTT_INBOUND_QUEUE_SIZE) {
+                    continue;
+                }
+
+                runBenchmark(async, (MqttQoS)qos, payload_sizes[i]);
+            }
+        }
+    }
+
+    MqttClient.enableInboundQueue(false);
+
+    Log.info(F("Benchmark done"));
+    MqttClient.end();
+}
+
+void loop() {}
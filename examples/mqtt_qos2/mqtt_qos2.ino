@@ -0,0 +1,164 @@
+/**
+ * This example verifies the QoS 2 (exactly once) delivery tracking against the
+ * Mosquitto broker at test.mosquitto.org. Messages are published with QoS 2
+ * to a topic the device is subscribed to with QoS 2, and the delivery states
+ * of the outgoing and incoming messages are printed along with how many times
+ * each message was received.
+ */
+
+#include <Arduino.h>
+
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+#include <mqtt_client.h>
+
+#define MQTT_TOPIC "mchp_qos2_topic/someuniquemchpqos2"
+
+#define MQTT_THING_NAME "someuniquemchpqos2"
+#define MQTT_BROKER     "test.mosquitto.org"
+#define MQTT_PORT       1883
+#define MQTT_USE_TLS    false
+#define MQTT_KEEPALIVE  60
+#define MQTT_USE_ECC    false
+
+#define NUMBER_OF_MESSAGES (3)
+
+// Time to wait for redeliveries after the last message has been received
+#define REDELIVERY_WAIT_MS (10000)
+
+static volatile int32_t received_message_id = -1;
+
+static uint8_t times_received[NUMBER_OF_MESSAGES];
+
+static const char* deliveryStateToString(const MqttDeliveryState state) {
+    switch (state) {
+    case MqttDeliveryState::RECEIVED:
+        return "RECEIVED";
+    case MqttDeliveryState::DELIVERED:
+        return "DELIVERED";
+    case MqttDeliveryState::PUBLISHED:
+        return "PUBLISHED";
+    case MqttDeliveryState::PUBLISH_FAILED:
+        return "PUBLISH_FAILED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+static void onMessage(__attribute__((unused)) const char* topic,
+                      __attribute__((unused)) const uint16_t message_length,
+                      const int32_t message_id) {
+    received_message_id = message_id;
+}
+
+/**
+ * @brief Reads a received message (if any) and counts it.
+ */
+static void readReceivedMessage(void) {
+
+    MqttClient.poll();
+
+    if (received_message_id < 0) {
+        return;
+    }
+
+    const int32_t message_id = received_message_id;
+    received_message_id      = -1;
+
+    char message[16] = "";
+
+    if (!MqttClient.readMessage(MQTT_TOPIC,
+                                message,
+                                sizeof(message),
+                                message_id)) {
+        Log.errorf(F("Failed to read message %ld\r\n"), message_id);
+        return;
+    }
+
+    const uint8_t index = atoi(message);
+
+    if (index < NUMBER_OF_MESSAGES) {
+        times_received[index]++;
+    }
+
+    Log.infof(F("Received message %u, delivery state: %s\r\n"),
+              index,
+              deliveryStateToString(MqttClient.getReceiveState(message_id)));
+}
+
+void setup() {
+    Log.begin(115200);
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.info(F("Starting MQTT QoS 2 example"));
+
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to operator"));
+        return;
+    }
+
+    if (!MqttClient.begin(MQTT_THING_NAME,
+                          MQTT_BROKER,
+                          MQTT_PORT,
+                          MQTT_USE_TLS,
+                          MQTT_KEEPALIVE,
+                          MQTT_USE_ECC)) {
+        Log.rawf(F("\r\n"));
+        Log.error(F("Failed to connect to broker"));
+        return;
+    }
+
+    if (!MqttClient.subscribe(MQTT_TOPIC, EXACTLY_ONCE, onMessage)) {
+        Log.error(F("Failed to subscribe"));
+        return;
+    }
+
+    for (uint8_t i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        char message[4];
+        snprintf(message, sizeof(message), "%u", i);
+
+        if (!MqttClient.publish(MQTT_TOPIC, message, EXACTLY_ONCE)) {
+            Log.errorf(F("Failed to publish message %u\r\n"), i);
+            continue;
+        }
+
+        const MqttDeliveryState state = MqttClient.getPublishState(
+            MqttClient.getLastPublishMessageId());
+
+        Log.infof(F("Published message %u, delivery state: %s\r\n"),
+                  i,
+                  deliveryStateToString(state));
+
+        const uint32_t start_ms = millis();
+
+        while (times_received[i] == 0 && millis() - start_ms < 10000) {
+            readReceivedMessage();
+        }
+    }
+
+    // Any redelivery of the messages should be discarded by the client
+    const uint32_t start_ms = millis();
+
+    while (millis() - start_ms < REDELIVERY_WAIT_MS) { readReceivedMessage(); }
+
+    uint8_t received   = 0;
+    uint8_t duplicates = 0;
+
+    for (uint8_t i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (times_received[i] > 0) {
+            received++;
+            duplicates += times_received[i] - 1;
+        }
+    }
+
+    Log.infof(F("Received %u of %u messages, %u duplicates\r\n"),
+              received,
+              NUMBER_OF_MESSAGES,
+              duplicates);
+
+    MqttClient.end();
+}
+
+void loop() {}
@@ -0,0 +1,100 @@
+/**
+ * @brief This example demonstrates staging a firmware image in flash with Ota
+ * and verifying its signature. To keep the example self-contained, the
+ * "image" is a deterministic test file served by httpbin.org and the digest is
+ * signed with the device's own key in the ECC. In a real deployment, the
+ * digest and the signature come from a manifest signed by the build server,
+ * and the public key of the build server is stored on the device.
+ *
+ * Installing the staged image is not part of the library and is not done here.
+ *
+ * The flash has to be writable from the application for this example, select
+ * "Everywhere" for the "Flash Writing" option of the board.
+ */
+#include <Arduino.h>
+#include <ecc608.h>
+#include <http_client.h>
+#include <led_ctrl.h>
+#include <log.h>
+#include <lte.h>
+#include <ota.h>
+
+#define DOMAIN     "httpbin.org"
+#define ENDPOINT   "/range/16384"
+#define IMAGE_SIZE (16384)
+
+// SHA-256 and CRC-32 of the file served at ENDPOINT, which is the alphabet
+// repeated
+const uint8_t IMAGE_SHA256[32] PROGMEM = {
+    0x2f, 0xca, 0xbb, 0xe3, 0xef, 0x90, 0xdb, 0x95, 0x2f, 0xf8, 0x0e,
+    0x3c, 0xd8, 0xd5, 0xc1, 0x9c, 0xd6, 0x89, 0x5f, 0xa4, 0x8d, 0x19,
+    0x78, 0x65, 0x2e, 0xa1, 0x0e, 0xe9, 0xe5, 0x8f, 0x1d, 0x4c};
+
+#define IMAGE_CRC32 (0x4AA39D4AUL)
+
+void setup() {
+    LedCtrl.begin();
+    LedCtrl.startupCycle();
+
+    Log.begin(115200);
+    Log.info(F("Starting OTA example"));
+
+    Ota.begin();
+
+    if (ECC608.begin() != ATCA_SUCCESS) {
+        Log.error(F("Failed to initialize the ECC"));
+        return;
+    }
+
+    HttpDownloadImage image = {};
+    image.size              = IMAGE_SIZE;
+    image.verify_crc32      = true;
+    image.crc32             = IMAGE_CRC32;
+    image.verify_sha256     = true;
+    memcpy_P(image.sha256, IMAGE_SHA256, sizeof(image.sha256));
+
+    // Stand-in for the signature in a manifest
+    uint8_t signature[64];
+    uint8_t public_key[64];
+
+    if (atcab_sign(0, image.sha256, signature) != ATCA_SUCCESS ||
+        atcab_get_pubkey(0, public_key) != ATCA_SUCCESS) {
+        Log.error(F("Failed to sign the digest of the image"));
+        return;
+    }
+
+    // Start modem and connect to the operator
+    if (!Lte.begin()) {
+        Log.error(F("Failed to connect to the operator"));
+        return;
+    }
+
+    Log.infof(F("Connected to operator: %s\r\n"), Lte.getOperator().c_str());
+
+    if (!HttpClient.configure(DOMAIN, 80, false)) {
+        Log.info(F("Failed to configure http client\r\n"));
+        return;
+    }
+
+    // Always start from scratch, so that the example downloads the whole image
+    HttpDownload.clearProgress();
+
+    const OtaResult result = Ota.stage(ENDPOINT, image, signature, public_key);
+
+    if (result != OtaResult::OK) {
+        Log.errorf(F("Failed to stage the firmware image, result: %d\r\n"),
+                   static_cast<int>(result));
+        return;
+    }
+
+    OtaStagedImage staged_image;
+
+    if (Ota.getStagedImage(&staged_image)) {
+        Log.infof(F("Staged image of %lu bytes at 0x%lX, CRC-32 %08lX\r\n"),
+                  staged_image.size,
+                  staged_image.address,
+                  staged_image.crc32);
+    }
+}
+
+void loop() {}
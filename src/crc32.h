@@ -0,0 +1,17 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+/**
+ * @brief Initial value of a CRC-32 (as used by gzip, zip and Ethernet).
+ */
+#define CRC32_INITIAL_VALUE (0xFFFFFFFFUL)
+
+/**
+ * @brief Continues the CRC-32 calculation @p crc with @p data. Start with
+ * #CRC32_INITIAL_VALUE and invert the result after the last update.
+ */
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, const uint16_t length);
+
+#endif
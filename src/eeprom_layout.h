@@ -0,0 +1,52 @@
+/**
+ * @brief Map of the EEPROM used by the library. The records are placed
+ * together at the top of the EEPROM, so that the addresses from 0 and up are
+ * left to the application:
+ *
+ * | Offset from base | Size | Record                                         |
+ * | ---------------- | ---- | ---------------------------------------------- |
+ * | 0                | 64   | MQTT QoS 2 delivery state table (MqttClient)   |
+ * | 64               | 128  | Download progress (HttpDownload)               |
+ * | 192              | 96   | Last known cell and band selection (Lte)       |
+ *
+ * Every record is validated when it is read, so a record which has not been
+ * written yet or which has been overwritten by the application is ignored.
+ */
+
+#ifndef EEPROM_LAYOUT_H
+#define EEPROM_LAYOUT_H
+
+#include <avr/io.h>
+
+/**
+ * @brief Space reserved for each of the records.
+ */
+#define EEPROM_LAYOUT_MQTT_QOS2_SIZE      (64)
+#define EEPROM_LAYOUT_HTTP_DOWNLOAD_SIZE  (128)
+#define EEPROM_LAYOUT_LTE_CELL_CACHE_SIZE (96)
+
+#define EEPROM_LAYOUT_SIZE                                             \
+    (EEPROM_LAYOUT_MQTT_QOS2_SIZE + EEPROM_LAYOUT_HTTP_DOWNLOAD_SIZE + \
+     EEPROM_LAYOUT_LTE_CELL_CACHE_SIZE)
+
+/**
+ * @brief Address the records of the library start at. Defaults to the top of
+ * the EEPROM. To move the records, it has to be given as a compiler flag, as
+ * a define in a sketch does not reach the sources of the library.
+ */
+#ifndef EEPROM_LAYOUT_BASE_ADDRESS
+#define EEPROM_LAYOUT_BASE_ADDRESS (EEPROM_SIZE - EEPROM_LAYOUT_SIZE)
+#endif
+
+static_assert(EEPROM_LAYOUT_BASE_ADDRESS + EEPROM_LAYOUT_SIZE <= EEPROM_SIZE,
+              "The records of the library don't fit in the EEPROM");
+
+#define MQTT_QOS2_EEPROM_ADDRESS (EEPROM_LAYOUT_BASE_ADDRESS)
+
+#define HTTP_DOWNLOAD_EEPROM_ADDRESS \
+    (MQTT_QOS2_EEPROM_ADDRESS + EEPROM_LAYOUT_MQTT_QOS2_SIZE)
+
+#define LTE_CELL_CACHE_EEPROM_ADDRESS \
+    (HTTP_DOWNLOAD_EEPROM_ADDRESS + EEPROM_LAYOUT_HTTP_DOWNLOAD_SIZE)
+
+#endif
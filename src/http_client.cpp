@@ -2,6 +2,7 @@
 #include "flash_string.h"
 #include "led_ctrl.h"
 #include "log.h"
+#include "network_time.h"
 #include "security_profile.h"
 #include "sequans_controller.h"
 #include "timeout_timer.h"
@@ -24,6 +25,7 @@
 #define HTTP_RESPONSE_MAX_LENGTH         (84)
 #define HTTP_RESPONSE_STATUS_CODE_INDEX  (1)
 #define HTTP_RESPONSE_STATUS_CODE_LENGTH (3)
+#define HTTP_RESPONSE_CONTENT_TYPE_INDEX (2)
 #define HTTP_RESPONSE_DATA_SIZE_INDEX    (3)
 #define HTTP_RESPONSE_DATA_SIZE_LENGTH   (16)
 
@@ -36,6 +38,16 @@
 
 #define HTTP_TIMEOUT (20000)
 
+#define HTTP_STREAM_READ_TIMEOUT_MS (2000)
+
+// Size of the chunks the compressed body is read in when inflating
+#define HTTP_INFLATE_INPUT_CHUNK_SIZE (128)
+
+// Length of a HTTP date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+#define HTTP_DATE_LENGTH (29)
+
+#define SECONDS_PER_DAY (86400UL)
+
 // Content type specifiers for POST requests for the AT+SQNHTTPSND command
 const char HTTP_CONTENT_TYPE_APPLICATION_X_WWW_FORM_URLENCODED[] PROGMEM = "0";
 const char HTTP_CONTENT_TYPE_TEXT_PLAIN[] PROGMEM                        = "1";
@@ -48,13 +60,77 @@ const char HTTP_SHUTDOWN_URC[] PROGMEM = "SQNHTTPSH";
 
 HttpClientClass HttpClient = HttpClientClass::instance();
 
-static volatile bool got_shutdown_callback   = false;
-static volatile uint16_t shutdown_error_code = 0;
+const char HTTP_WEEKDAYS[] PROGMEM = "ThuFriSatSunMonTueWed";
+const char HTTP_MONTHS[] PROGMEM   = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+/**
+ * @brief Validator for an endpoint enabled for conditional requests, used to
+ * make the next GET of it conditional. The endpoint is identified by a hash.
+ * The time of the previous fetch is empty until it has been fetched.
+ */
+typedef struct {
+    uint16_t endpoint_hash;
+    char fetched_at[HTTP_DATE_LENGTH + 1];
+} HttpValidator;
+
+static HttpValidator validators[HTTP_VALIDATOR_CACHE_SIZE];
+static uint8_t num_validators = 0;
+
+static char last_content_type[HTTP_CONTENT_TYPE_MAX_LENGTH + 1] = "";
+
+/**
+ * @brief State of a modem HTTP profile. The configuration is cached so that
+ * the profile doesn't have to be configured again when switching between
+ * profiles. The response URCs are routed to the profile they are for by the
+ * profile ID in them.
+ */
+typedef struct {
+    uint16_t host_hash;
+    uint16_t port;
+    bool enable_tls;
+    bool configured;
+    volatile bool got_ring;
+    volatile bool got_shutdown;
+    volatile uint16_t shutdown_error_code;
+    char ring_data[HTTP_RESPONSE_MAX_LENGTH];
+} HttpProfileState;
+
+static HttpProfileState profiles[HTTP_MAX_PROFILES];
+static uint8_t active_profile = 0;
+
+static uint16_t stringHash(const char* string) {
+
+    uint32_t hash = 2166136261UL;
+
+    for (; *string != '\0'; string++) {
+        hash = (hash ^ (uint8_t)*string) * 16777619UL;
+    }
+
+    return (uint16_t)(hash >> 16) ^ (uint16_t)hash;
+}
+
+/**
+ * @return The profile ID at the start of the URC data, or -1 if it is not a
+ * profile we use.
+ */
+static int8_t urcProfileId(const char* urc) {
+    const int profile_id = atoi(urc);
+
+    return (profile_id >= 0 && profile_id < HTTP_MAX_PROFILES) ? profile_id
+                                                                : -1;
+}
 
 /**
  * @brief Registered as a callback for the HTTP shutdown URC.
  */
 static void httpShutdownCallback(char* urc) {
+
+    const int8_t profile_id = urcProfileId(urc);
+
+    if (profile_id < 0) {
+        return;
+    }
+
     char error_code_buffer[8] = "";
 
     const bool got_error_code =
@@ -69,8 +145,157 @@ static void httpShutdownCallback(char* urc) {
         return;
     }
 
-    got_shutdown_callback = true;
-    shutdown_error_code   = atoi(error_code_buffer);
+    profiles[profile_id].got_shutdown        = true;
+    profiles[profile_id].shutdown_error_code = atoi(error_code_buffer);
+}
+
+/**
+ * @brief Registered as a callback for the HTTP response URC.
+ */
+static void httpRingCallback(char* urc) {
+
+    const int8_t profile_id = urcProfileId(urc);
+
+    if (profile_id < 0) {
+        return;
+    }
+
+    HttpProfileState* profile = &profiles[profile_id];
+
+    strncpy(profile->ring_data, urc, sizeof(profile->ring_data) - 1);
+    profile->ring_data[sizeof(profile->ring_data) - 1] = '\0';
+
+    profile->got_ring = true;
+}
+
+/**
+ * @brief Starts listening for the response URCs for the active profile. Has
+ * to be done before the request is issued so that a quick response is not
+ * missed.
+ */
+static void prepareForResponse(void) {
+
+    cli();
+    profiles[active_profile].got_ring     = false;
+    profiles[active_profile].got_shutdown = false;
+    sei();
+
+    SequansController.registerCallback(FV(HTTP_RING_URC), httpRingCallback);
+
+    // If the request fails for some reason, we will retrieve the SQNHTTPSH
+    // (shutdown) URC which has the reason for failure, so we want to listen for
+    // that as well
+    SequansController.registerCallback(FV(HTTP_SHUTDOWN_URC),
+                                       httpShutdownCallback);
+}
+
+static void stopListeningForResponse(void) {
+    SequansController.unregisterCallback(FV(HTTP_RING_URC));
+    SequansController.unregisterCallback(FV(HTTP_SHUTDOWN_URC));
+}
+
+typedef struct {
+    uint16_t endpoint_hash;
+    HttpEndpointStatistics statistics;
+} EndpointStatisticsEntry;
+
+static EndpointStatisticsEntry
+    endpoint_statistics[HTTP_STATISTICS_MAX_ENDPOINTS];
+static uint8_t num_endpoint_statistics  = 0;
+static uint8_t next_endpoint_statistics = 0;
+
+// The statistics the current request and the reads of its body are added to
+static HttpEndpointStatistics* request_statistics = NULL;
+
+static HttpRequestTimings last_timings = {};
+static uint32_t request_start_ms       = 0;
+
+/**
+ * @brief Identifies an endpoint on the active profile. The host is part of
+ * the key as the same endpoint can exist on the hosts of several profiles.
+ */
+static uint16_t endpointKey(const char* endpoint) {
+    return stringHash(endpoint) ^ profiles[active_profile].host_hash;
+}
+
+static EndpointStatisticsEntry* findEndpointStatistics(const uint16_t key) {
+
+    for (uint8_t i = 0; i < num_endpoint_statistics; i++) {
+        if (endpoint_statistics[i].endpoint_hash == key) {
+            return &endpoint_statistics[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t elapsedSinceRequestStart(void) {
+    return millis() - request_start_ms;
+}
+
+static void startRequestTimings(const char* endpoint) {
+
+    memset(&last_timings, 0, sizeof(last_timings));
+    request_start_ms = millis();
+
+    const uint16_t key             = endpointKey(endpoint);
+    EndpointStatisticsEntry* entry = findEndpointStatistics(key);
+
+    if (entry == NULL) {
+        entry = &endpoint_statistics[next_endpoint_statistics];
+        memset(entry, 0, sizeof(EndpointStatisticsEntry));
+        entry->endpoint_hash = key;
+
+        next_endpoint_statistics = (next_endpoint_statistics + 1) %
+                                   HTTP_STATISTICS_MAX_ENDPOINTS;
+
+        if (num_endpoint_statistics < HTTP_STATISTICS_MAX_ENDPOINTS) {
+            num_endpoint_statistics++;
+        }
+    }
+
+    request_statistics = &entry->statistics;
+    request_statistics->requests++;
+}
+
+/**
+ * @brief Adds the request to the statistics of its endpoint.
+ *
+ * @return @p response, so that this can wrap the return value.
+ */
+static HttpResponse finishRequestTimings(const HttpResponse response) {
+
+    request_statistics->bytes_sent += last_timings.bytes_sent;
+
+    // The modem reports status code 0 when the connection failed
+    if (response.status_code == 0) {
+        request_statistics->failures++;
+        return response;
+    }
+
+    uint8_t bucket = 0;
+
+    while (bucket < HTTP_HISTOGRAM_BUCKETS - 1 &&
+           last_timings.response_ms >= (HTTP_HISTOGRAM_FIRST_BUCKET_MS
+                                        << bucket)) {
+        bucket++;
+    }
+
+    request_statistics->response_histogram[bucket]++;
+
+    return response;
+}
+
+static void recordBodyRead(const uint16_t length) {
+
+    last_timings.bytes_received += length;
+    last_timings.receive_round_trips++;
+    last_timings.body_read_ms = elapsedSinceRequestStart();
+
+    if (request_statistics != NULL) {
+        request_statistics->bytes_received += length;
+        request_statistics->receive_round_trips++;
+    }
 }
 
 /**
@@ -82,30 +307,28 @@ static HttpResponse waitForResponse(const uint32_t timeout_ms) {
 
     HttpResponse http_response = {0, 0, 0};
 
-    char http_response_buffer[HTTP_RESPONSE_MAX_LENGTH]                = "";
     char http_status_code_buffer[HTTP_RESPONSE_STATUS_CODE_LENGTH + 1] = "";
     char data_size_buffer[HTTP_RESPONSE_DATA_SIZE_LENGTH]              = "";
 
-    const auto toggle_led_whilst_waiting = [] {
-        LedCtrl.toggle(Led::DATA, true);
-    };
+    HttpProfileState* profile  = &profiles[active_profile];
+    char* http_response_buffer = profile->ring_data;
 
-    // If the request fails for some reason, we will retrieve the SQNHTTPSH
-    // (shutdown) URC which has the reason for failure, so we want to listen for
-    // that as well
-    got_shutdown_callback = false;
-    SequansController.registerCallback(FV(HTTP_SHUTDOWN_URC),
-                                       httpShutdownCallback);
+    const TimeoutTimer timeout_timer(timeout_ms);
+    uint32_t last_toggle_ms = millis();
+
+    while (!profile->got_ring && !timeout_timer.hasTimedOut()) {
+        if (millis() - last_toggle_ms >= 500) {
+            LedCtrl.toggle(Led::DATA, true);
+            last_toggle_ms = millis();
+        }
+
+        _delay_ms(1);
+    }
 
-    if (!SequansController.waitForURC(FV(HTTP_RING_URC),
-                                      http_response_buffer,
-                                      sizeof(http_response_buffer),
-                                      timeout_ms,
-                                      toggle_led_whilst_waiting,
-                                      500)) {
+    if (!profile->got_ring) {
         LedCtrl.off(Led::DATA, true);
 
-        SequansController.unregisterCallback(FV(HTTP_SHUTDOWN_URC));
+        stopListeningForResponse();
 
         Log.warnf(F("Did not get HTTP response before timeout on %d ms. "
                     "Consider increasing the timeout.\r\n"),
@@ -114,6 +337,8 @@ static HttpResponse waitForResponse(const uint32_t timeout_ms) {
         return http_response;
     }
 
+    last_timings.response_ms = elapsedSinceRequestStart();
+
     // We pass 0 as the start character here as the URC data will only
     // contain the payload, not the URC identifier
     const bool got_response_code =
@@ -142,41 +367,96 @@ static HttpResponse waitForResponse(const uint32_t timeout_ms) {
             // URC some time to arrive here.
             TimeoutTimer timer(1000);
 
-            while (!got_shutdown_callback && !timer.hasTimedOut()) {
+            while (!profile->got_shutdown && !timer.hasTimedOut()) {
                 _delay_ms(1);
             }
 
-            if (got_shutdown_callback) {
-                if (shutdown_error_code != 0) {
+            if (profile->got_shutdown) {
+                if (profile->shutdown_error_code != 0) {
                     Log.errorf(
                         F("HTTP request failed with curl error code: %d. "
                           "Please refer to libcurl's error codes for more "
                           "information.\r\n"),
-                        shutdown_error_code);
+                        profile->shutdown_error_code);
                 }
 
-                http_response.curl_error_code = shutdown_error_code;
+                http_response.curl_error_code = profile->shutdown_error_code;
             }
         }
     }
 
     if (got_data_size) {
-        http_response.data_size = atoi(data_size_buffer);
+        http_response.data_size = strtoul(data_size_buffer, NULL, 10);
     }
 
-    SequansController.unregisterCallback(FV(HTTP_SHUTDOWN_URC));
+    if (!SequansController.extractValueFromCommandResponse(
+            http_response_buffer,
+            HTTP_RESPONSE_CONTENT_TYPE_INDEX,
+            last_content_type,
+            sizeof(last_content_type),
+            0)) {
+        last_content_type[0] = '\0';
+    }
+
+    stopListeningForResponse();
 
     LedCtrl.off(Led::DATA, true);
 
     return http_response;
 }
 
+/**
+ * @brief Writes @p data_length bytes of payload requested from @p producer in
+ * chunks, so that only one chunk has to be held in RAM.
+ *
+ * @return false if the producer stopped delivering data before the whole
+ * payload was written. The rest of the payload is then padded with zeros, as
+ * the modem expects the length given in the command.
+ */
+static bool writeProducedData(const uint32_t data_length,
+                              HttpDataProducer producer) {
+
+    uint8_t chunk[HTTP_STREAM_CHUNK_SIZE];
+    uint32_t offset = 0;
+    bool producing  = true;
+
+    while (offset < data_length) {
+
+        const uint16_t requested_length = min(data_length - offset,
+                                              (uint32_t)sizeof(chunk));
+
+        uint16_t chunk_length = 0;
+
+        if (producing) {
+            chunk_length = producer(chunk, requested_length, offset);
+            chunk_length = min(chunk_length, requested_length);
+        }
+
+        if (chunk_length == 0) {
+            producing    = false;
+            chunk_length = requested_length;
+            memset(chunk, 0, chunk_length);
+        }
+
+        offset += chunk_length;
+
+        // The carriage return terminates the payload
+        SequansController.writeBytes(chunk,
+                                     chunk_length,
+                                     offset == data_length);
+    }
+
+    return producing;
+}
+
 /**
  * @brief Generic method for sending data via HTTP, either with POST or PUT.
  *
  * @param endpoint Destination of payload, part after host name in URL.
- * @param data Payload to send.
+ * @param data Payload to send. Not used if @p producer is given.
  * @param data_length Length of payload.
+ * @param producer If not NULL, the payload is requested from the producer in
+ * chunks instead of being sent from @p data.
  * @param method POST(0) or PUT(1).
  * @param header Optional header.
  * @param timeout_ms Timeout in milliseconds for the transmission.
@@ -185,11 +465,14 @@ static HttpResponse
 sendData(const char* endpoint,
          const uint8_t* data,
          const uint32_t data_length,
+         HttpDataProducer producer,
          const uint8_t method,
          const char* header        = NULL,
          const char* content_type  = "",
          const uint32_t timeout_ms = HTTP_DEFAULT_TIMEOUT_MS) {
 
+    startRequestTimings(endpoint);
+
     LedCtrl.on(Led::CON, true);
 
     // The modem could hang if several HTTP requests are done quickly after each
@@ -198,18 +481,24 @@ sendData(const char* endpoint,
 
     HttpResponse http_response = {0, 0, 0};
 
+    prepareForResponse();
+
     if (!SequansController.writeString(
-            F("AT+SQNHTTPSND=0,%u,\"%s\",%lu,\"%s\",\"%s\""),
+            F("AT+SQNHTTPSND=%u,%u,\"%s\",%lu,\"%s\",\"%s\""),
             true,
+            active_profile,
             method,
             endpoint,
             (unsigned long)data_length,
             content_type,
             header == NULL ? "" : (const char*)header)) {
         Log.error(F("Was not able to write HTTP AT command\r\n"));
-        return http_response;
+        stopListeningForResponse();
+        return finishRequestTimings(http_response);
     }
 
+    last_timings.command_ms = elapsedSinceRequestStart();
+
     // Only send the data payload if there is any
     if (data_length > 0) {
 
@@ -221,19 +510,37 @@ sendData(const char* endpoint,
                   "server online? If you're using HTTPS, you might need to "
                   "provision with a different CA certificate."));
 
+            stopListeningForResponse();
             LedCtrl.off(Led::CON, true);
-            return http_response;
+            return finishRequestTimings(http_response);
         }
 
+        last_timings.payload_prompt_ms = elapsedSinceRequestStart();
+
         // Now we deliver the payload
-        SequansController.writeBytes(data, data_length, true);
+        if (producer == NULL) {
+            SequansController.writeBytes(data, data_length, true);
+        } else if (!writeProducedData(data_length, producer)) {
+            Log.error(F("HTTP payload producer did not deliver the whole "
+                        "payload, the rest was padded with zeros"));
+
+            // Still wait for the response so that the modem is ready for the
+            // next request
+            waitForResponse(timeout_ms);
+
+            LedCtrl.off(Led::CON, true);
+            return finishRequestTimings(http_response);
+        }
+
+        last_timings.payload_sent_ms = elapsedSinceRequestStart();
+        last_timings.bytes_sent      = data_length;
     }
 
     http_response = waitForResponse(timeout_ms);
 
     LedCtrl.off(Led::CON, true);
 
-    return http_response;
+    return finishRequestTimings(http_response);
 }
 
 /**
@@ -250,6 +557,8 @@ static HttpResponse queryData(const char* endpoint,
                               const uint8_t* header,
                               const uint32_t timeout_ms) {
 
+    startRequestTimings(endpoint);
+
     LedCtrl.on(Led::CON, true);
 
     // The modem could hang if several HTTP requests are done quickly after each
@@ -258,10 +567,13 @@ static HttpResponse queryData(const char* endpoint,
 
     HttpResponse http_response = {0, 0, 0};
 
+    prepareForResponse();
+
     const ResponseResult response = SequansController.writeCommand(
-        F("AT+SQNHTTPQRY=0,%u,\"%s\",\"%s\""),
+        F("AT+SQNHTTPQRY=%u,%u,\"%s\",\"%s\""),
         NULL,
         0,
+        active_profile,
         method,
         endpoint,
         header == NULL ? "" : (const char*)header);
@@ -269,19 +581,141 @@ static HttpResponse queryData(const char* endpoint,
     if (response != ResponseResult::OK) {
         Log.errorf(F("Was not able to write HTTP AT command, error: %X\r\n"),
                    static_cast<uint8_t>(response));
-        return http_response;
+        stopListeningForResponse();
+        return finishRequestTimings(http_response);
     }
 
+    last_timings.command_ms = elapsedSinceRequestStart();
+
     http_response = waitForResponse(timeout_ms);
 
     LedCtrl.off(Led::CON, true);
 
-    return http_response;
+    return finishRequestTimings(http_response);
 }
 
-bool HttpClientClass::configure(const char* host,
-                                const uint16_t port,
-                                const bool enable_tls) {
+/**
+ * @brief Converts the content type to the single character specifier used by
+ * the modem.
+ *
+ * @param content_type_buffer Destination, has to fit two characters.
+ */
+static void
+contentTypeToSpecifier(const HttpClientClass::ContentType content_type,
+                       char* content_type_buffer) {
+
+    switch (content_type) {
+    case HttpClientClass::CONTENT_TYPE_APPLICATION_X_WWW_FORM_URLENCODED:
+        strcpy_P(content_type_buffer,
+                 HTTP_CONTENT_TYPE_APPLICATION_X_WWW_FORM_URLENCODED);
+        break;
+
+    case HttpClientClass::CONTENT_TYPE_APPLICATION_OCTET_STREAM:
+        strcpy_P(content_type_buffer,
+                 HTTP_CONTENT_TYPE_APPLICATION_OCTET_STREAM);
+        break;
+
+    case HttpClientClass::CONTENT_TYPE_MULTIPART_FORM_DATA:
+        strcpy_P(content_type_buffer,
+                 HTTP_CONTENT_TYPE_APPLICATION_MULTIPART_FORM_DATA);
+        break;
+
+    case HttpClientClass::CONTENT_TYPE_APPLICATION_JSON:
+        strcpy_P(content_type_buffer,
+                 HTTP_CONTENT_TYPE_APPLICATION_APPLICATION_JSON);
+        break;
+
+    default:
+        strcpy_P(content_type_buffer, HTTP_CONTENT_TYPE_TEXT_PLAIN);
+        break;
+    }
+}
+
+static HttpValidator* findValidator(const uint16_t endpoint_hash) {
+
+    for (uint8_t i = 0; i < num_validators; i++) {
+        if (validators[i].endpoint_hash == endpoint_hash) {
+            return &validators[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Converts days since 1970-01-01 to a date.
+ */
+static void civilFromDays(int32_t days,
+                          int16_t* year,
+                          uint8_t* month,
+                          uint8_t* day) {
+
+    days += 719468;
+
+    const int32_t era           = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t day_of_era   = days - era * 146097;
+    const uint16_t year_of_era  = (day_of_era - day_of_era / 1460 +
+                                  day_of_era / 36524 - day_of_era / 146096) /
+                                 365;
+    const uint16_t day_of_year  = day_of_era - (365UL * year_of_era +
+                                               year_of_era / 4 -
+                                               year_of_era / 100);
+    const uint8_t shifted_month = (5 * day_of_year + 2) / 153;
+
+    *day   = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year  = year_of_era + era * 400 + (*month <= 2);
+}
+
+/**
+ * @brief Retrieves the current network time as a HTTP date in GMT.
+ *
+ * @param date Destination, has to fit #HTTP_DATE_LENGTH + 1 characters.
+ */
+static bool retrieveHttpDate(char* date) {
+
+    const uint32_t epoch = NetworkTime.now();
+
+    if (epoch == 0) {
+        return false;
+    }
+
+    const uint32_t days           = epoch / SECONDS_PER_DAY;
+    const uint32_t seconds_of_day = epoch % SECONDS_PER_DAY;
+
+    int16_t utc_year;
+    uint8_t utc_month, utc_day;
+    civilFromDays(days, &utc_year, &utc_month, &utc_day);
+
+    // 1970-01-01 was a Thursday, which the weekday table starts with
+    const uint8_t weekday = days % 7;
+
+    char weekday_name[4] = "";
+    char month_name[4]   = "";
+    memcpy_P(weekday_name, &HTTP_WEEKDAYS[weekday * 3], 3);
+    memcpy_P(month_name, &HTTP_MONTHS[(utc_month - 1) * 3], 3);
+
+    snprintf_P(date,
+               HTTP_DATE_LENGTH + 1,
+               PSTR("%s, %02u %s %04d %02u:%02u:%02u GMT"),
+               weekday_name,
+               utc_day,
+               month_name,
+               utc_year,
+               (uint8_t)(seconds_of_day / 3600),
+               (uint8_t)((seconds_of_day / 60) % 60),
+               (uint8_t)(seconds_of_day % 60));
+
+    return true;
+}
+
+/**
+ * @brief Configures @p profile_id in the modem and caches the configuration.
+ */
+static bool configureProfile(const uint8_t profile_id,
+                             const char* host,
+                             const uint16_t port,
+                             const bool enable_tls) {
 
     if (enable_tls) {
         if (!SecurityProfile.profileExists(HTTPS_SECURITY_PROFILE_NUMBER)) {
@@ -292,15 +726,114 @@ bool HttpClientClass::configure(const char* host,
         }
     }
 
-    // We only use profile 0 to keep things simple we also stick with spId 3
-    // which we dedicate to HTTPS
-    return SequansController.writeCommand(
-               F("AT+SQNHTTPCFG=0,\"%s\",%u,0,\"\",\"\",%u,120,,3"),
-               NULL,
-               0,
-               host,
-               port,
-               enable_tls ? 1 : 0) == ResponseResult::OK;
+    HttpProfileState* profile = &profiles[profile_id];
+    profile->configured       = false;
+
+    // We stick with spId 3 which we dedicate to HTTPS for all profiles
+    if (SequansController.writeCommand(
+            F("AT+SQNHTTPCFG=%u,\"%s\",%u,0,\"\",\"\",%u,120,,3"),
+            NULL,
+            0,
+            profile_id,
+            host,
+            port,
+            enable_tls ? 1 : 0) != ResponseResult::OK) {
+        return false;
+    }
+
+    profile->host_hash  = stringHash(host);
+    profile->port       = port;
+    profile->enable_tls = enable_tls;
+    profile->configured = true;
+
+    return true;
+}
+
+bool HttpClientClass::configure(const char* host,
+                                const uint16_t port,
+                                const bool enable_tls) {
+
+    // Profile 0 is reserved for the single host set up with this function, so
+    // that it keeps working as before alongside the opened profiles
+    if (!configureProfile(0, host, port, enable_tls)) {
+        return false;
+    }
+
+    active_profile = 0;
+
+    return true;
+}
+
+int8_t HttpClientClass::openProfile(const char* host,
+                                    const uint16_t port,
+                                    const bool enable_tls) {
+
+    const uint16_t host_hash = stringHash(host);
+    int8_t free_profile_id   = -1;
+
+    for (uint8_t i = 1; i < HTTP_MAX_PROFILES; i++) {
+        const HttpProfileState* profile = &profiles[i];
+
+        if (!profile->configured) {
+            if (free_profile_id < 0) {
+                free_profile_id = i;
+            }
+
+            continue;
+        }
+
+        // Already configured for this host, so no need to configure it again
+        if (profile->host_hash == host_hash && profile->port == port &&
+            profile->enable_tls == enable_tls) {
+            return i;
+        }
+    }
+
+    if (free_profile_id < 0) {
+        Log.error(F("No free HTTP profile, close one of the open profiles "
+                    "first\r\n"));
+        return -1;
+    }
+
+    if (!configureProfile(free_profile_id, host, port, enable_tls)) {
+        return -1;
+    }
+
+    return free_profile_id;
+}
+
+bool HttpClientClass::useProfile(const int8_t handle) {
+
+    if (handle < 0 || handle >= HTTP_MAX_PROFILES ||
+        !profiles[handle].configured) {
+        return false;
+    }
+
+    active_profile = handle;
+
+    return true;
+}
+
+void HttpClientClass::closeProfile(const int8_t handle) {
+
+    if (handle < 0 || handle >= HTTP_MAX_PROFILES) {
+        return;
+    }
+
+    profiles[handle].configured = false;
+
+    if (active_profile == handle) {
+        active_profile = 0;
+    }
+}
+
+void HttpClientClass::end(void) {
+
+    for (uint8_t i = 0; i < HTTP_MAX_PROFILES; i++) {
+        profiles[i].configured = false;
+    }
+
+    active_profile = 0;
 }
 
 HttpResponse HttpClientClass::post(const char* endpoint,
@@ -314,32 +847,7 @@ HttpResponse HttpClientClass::post(const char* endpoint,
     // The content type within the Sequans modem is classified by a single
     // character (+1 for NULL termination)
     char content_type_buffer[2] = "";
-
-    switch (content_type) {
-    case CONTENT_TYPE_APPLICATION_X_WWW_FORM_URLENCODED:
-        strcpy_P(content_type_buffer,
-                 HTTP_CONTENT_TYPE_APPLICATION_X_WWW_FORM_URLENCODED);
-        break;
-
-    case CONTENT_TYPE_APPLICATION_OCTET_STREAM:
-        strcpy_P(content_type_buffer,
-                 HTTP_CONTENT_TYPE_APPLICATION_OCTET_STREAM);
-        break;
-
-    case CONTENT_TYPE_MULTIPART_FORM_DATA:
-        strcpy_P(content_type_buffer,
-                 HTTP_CONTENT_TYPE_APPLICATION_MULTIPART_FORM_DATA);
-        break;
-
-    case CONTENT_TYPE_APPLICATION_JSON:
-        strcpy_P(content_type_buffer,
-                 HTTP_CONTENT_TYPE_APPLICATION_APPLICATION_JSON);
-        break;
-
-    default:
-        strcpy_P(content_type_buffer, HTTP_CONTENT_TYPE_TEXT_PLAIN);
-        break;
-    }
+    contentTypeToSpecifier(content_type, content_type_buffer);
 
     char header[header_length + 1] = "";
     strncpy(header, (const char*)header_buffer, header_length);
@@ -348,6 +856,7 @@ HttpResponse HttpClientClass::post(const char* endpoint,
     return sendData(endpoint,
                     data_buffer,
                     data_length,
+                    NULL,
                     HTTP_POST_METHOD,
                     header,
                     content_type_buffer,
@@ -382,6 +891,7 @@ HttpResponse HttpClientClass::put(const char* endpoint,
     return sendData(endpoint,
                     data_buffer,
                     data_length,
+                    NULL,
                     HTTP_PUT_METHOD,
                     header,
                     "",
@@ -400,10 +910,134 @@ HttpResponse HttpClientClass::put(const char* endpoint,
                timeout_ms);
 }
 
+HttpResponse HttpClientClass::post(const char* endpoint,
+                                   const uint32_t data_length,
+                                   HttpDataProducer producer,
+                                   const char* header,
+                                   const ContentType content_type,
+                                   const uint32_t timeout_ms) {
+
+    char content_type_buffer[2] = "";
+    contentTypeToSpecifier(content_type, content_type_buffer);
+
+    return sendData(endpoint,
+                    NULL,
+                    data_length,
+                    producer,
+                    HTTP_POST_METHOD,
+                    header,
+                    content_type_buffer,
+                    timeout_ms);
+}
+
+HttpResponse HttpClientClass::put(const char* endpoint,
+                                  const uint32_t data_length,
+                                  HttpDataProducer producer,
+                                  const char* header,
+                                  const uint32_t timeout_ms) {
+    return sendData(endpoint,
+                    NULL,
+                    data_length,
+                    producer,
+                    HTTP_PUT_METHOD,
+                    header,
+                    "",
+                    timeout_ms);
+}
+
 HttpResponse HttpClientClass::get(const char* endpoint,
                                   const char* header,
                                   const uint32_t timeout_ms) {
-    return queryData(endpoint, HTTP_GET_METHOD, (uint8_t*)header, timeout_ms);
+
+    HttpValidator* validator = findValidator(endpointKey(endpoint));
+
+    // The modem only takes one extra header line, so requests with a header
+    // of their own can't be made conditional
+    if (validator == NULL || (header != NULL && header[0] != '\0')) {
+        return queryData(endpoint,
+                         HTTP_GET_METHOD,
+                         (uint8_t*)header,
+                         timeout_ms);
+    }
+
+    // The time is retrieved before the request so that changes made whilst
+    // the request is in flight are not missed by the next request
+    char request_date[HTTP_DATE_LENGTH + 1] = "";
+    const bool got_request_date             = retrieveHttpDate(request_date);
+
+    HttpResponse response;
+
+    if (validator->fetched_at[0] != '\0') {
+        char conditional_header[sizeof("If-Modified-Since: ") +
+                                HTTP_DATE_LENGTH] = "";
+
+        snprintf_P(conditional_header,
+                   sizeof(conditional_header),
+                   PSTR("If-Modified-Since: %s"),
+                   validator->fetched_at);
+
+        response = queryData(endpoint,
+                             HTTP_GET_METHOD,
+                             (uint8_t*)conditional_header,
+                             timeout_ms);
+
+        if (response.status_code == STATUS_NOT_MODIFIED) {
+            Log.debugf(F("%s not modified since %s\r\n"),
+                       endpoint,
+                       validator->fetched_at);
+            return response;
+        }
+    } else {
+        response = queryData(endpoint, HTTP_GET_METHOD, NULL, timeout_ms);
+    }
+
+    if (response.status_code == STATUS_OK && got_request_date) {
+        strcpy(validator->fetched_at, request_date);
+    }
+
+    return response;
+}
+
+bool HttpClientClass::enableConditionalRequests(const char* endpoint) {
+
+    const uint16_t endpoint_hash = endpointKey(endpoint);
+
+    if (findValidator(endpoint_hash) != NULL) {
+        return true;
+    }
+
+    if (num_validators >= HTTP_VALIDATOR_CACHE_SIZE) {
+        return false;
+    }
+
+    validators[num_validators].endpoint_hash = endpoint_hash;
+    validators[num_validators].fetched_at[0] = '\0';
+    num_validators++;
+
+    return true;
+}
+
+void HttpClientClass::disableConditionalRequests(const char* endpoint) {
+
+    HttpValidator* validator = findValidator(endpointKey(endpoint));
+
+    if (validator == NULL) {
+        return;
+    }
+
+    // Keep the validators packed by moving the last one into the gap
+    *validator = validators[--num_validators];
+}
+
+void HttpClientClass::clearValidators(void) {
+
+    for (uint8_t i = 0; i < num_validators; i++) {
+        validators[i].fetched_at[0] = '\0';
+    }
+}
+
+const char* HttpClientClass::getLastContentType(void) {
+    return last_content_type;
 }
 
 HttpResponse HttpClientClass::head(const char* endpoint,
@@ -436,8 +1070,9 @@ int16_t HttpClientClass::readBody(char* buffer, const uint32_t buffer_size) {
 
     // We send the buffer size with the receive command so that we only
     // receive that. The rest will be flushed from the modem.
-    if (!SequansController.writeString(F("AT+SQNHTTPRCV=0,%lu"),
+    if (!SequansController.writeString(F("AT+SQNHTTPRCV=%u,%lu"),
                                        true,
+                                       active_profile,
                                        buffer_size)) {
         Log.error(F("Was not able to write HTTP read body AT command\r\n"));
         return -1;
@@ -459,7 +1094,237 @@ int16_t HttpClientClass::readBody(char* buffer, const uint32_t buffer_size) {
         return 0;
     }
 
-    return strlen(buffer);
+    const uint16_t length = strlen(buffer);
+    recordBodyRead(length);
+
+    return length;
+}
+
+/**
+ * @brief Waits for a byte from the modem for at most
+ * #HTTP_STREAM_READ_TIMEOUT_MS.
+ *
+ * @return The byte or -1 if the timeout was reached.
+ */
+static int16_t readBodyByte(void) {
+
+    const TimeoutTimer timeout_timer(HTTP_STREAM_READ_TIMEOUT_MS);
+
+    while (!SequansController.isRxReady() && !timeout_timer.hasTimedOut()) {
+        _delay_ms(1);
+    }
+
+    if (!SequansController.isRxReady()) {
+        return -1;
+    }
+
+    return SequansController.readByte();
+}
+
+/**
+ * @brief Reads one chunk of the body with AT+SQNHTTPRCV. The chunk is read by
+ * its length and not by searching for the termination, so binary bodies are
+ * handled as well.
+ */
+static bool readBodyChunk(uint8_t* chunk, const uint16_t chunk_length) {
+
+    // The modem requires that we ask for at least the minimum, but it will
+    // only give us what is left of the body
+    if (!SequansController.writeString(
+            F("AT+SQNHTTPRCV=%u,%u"),
+            true,
+            active_profile,
+            max(chunk_length, (uint16_t)HTTP_BODY_BUFFER_MIN_SIZE))) {
+        Log.error(F("Was not able to write HTTP read body AT command\r\n"));
+        return false;
+    }
+
+    // We receive three start bytes '<', have to wait for them
+    uint8_t start_bytes = 3;
+
+    while (start_bytes > 0) {
+        const int16_t byte = readBodyByte();
+
+        if (byte < 0) {
+            return false;
+        }
+
+        if (byte == '<') {
+            start_bytes--;
+        }
+    }
+
+    for (uint16_t i = 0; i < chunk_length; i++) {
+        const int16_t byte = readBodyByte();
+
+        if (byte < 0) {
+            return false;
+        }
+
+        chunk[i] = (uint8_t)byte;
+    }
+
+    // Consume the termination after the payload
+    if (SequansController.readResponse(NULL, 0) != ResponseResult::OK) {
+        return false;
+    }
+
+    recordBodyRead(chunk_length);
+
+    return true;
+}
+
+uint32_t HttpClientClass::streamBody(const uint32_t data_size,
+                                     void (*sink)(const uint8_t* chunk,
+                                                  const uint16_t chunk_length,
+                                                  const uint32_t offset),
+                                     const uint16_t chunk_size) {
+
+    if (chunk_size < HTTP_BODY_BUFFER_MIN_SIZE ||
+        chunk_size > HTTP_BODY_BUFFER_MAX_SIZE) {
+        return 0;
+    }
+
+    uint8_t chunk[chunk_size];
+    uint32_t offset = 0;
+
+    LedCtrl.on(Led::DATA, true);
+
+    // Fix for bringing the modem out of idling and prevent timeout whilst
+    // waiting for modem response during the next AT command
+    SequansController.writeCommand(F("AT"));
+
+    while (offset < data_size) {
+        const uint16_t chunk_length = min(data_size - offset,
+                                          (uint32_t)chunk_size);
+
+        if (!readBodyChunk(chunk, chunk_length)) {
+            Log.errorf(F("Failed to read HTTP body at offset %lu of %lu\r\n"),
+                       offset,
+                       data_size);
+            break;
+        }
+
+        sink(chunk, chunk_length, offset);
+        offset += chunk_length;
+    }
+
+    LedCtrl.off(Led::DATA, true);
+
+    return offset;
+}
+
+static uint8_t* inflate_input               = NULL;
+static uint16_t inflate_input_length        = 0;
+static uint16_t inflate_input_position      = 0;
+static uint32_t inflate_remaining_body_size = 0;
+
+/**
+ * @brief Feeds the inflater with the compressed body, reading the next chunk
+ * from the modem when the current one is used up.
+ */
+static int16_t readCompressedBodyByte(void) {
+
+    if (inflate_input_position == inflate_input_length) {
+
+        if (inflate_remaining_body_size == 0) {
+            return -1;
+        }
+
+        const uint16_t chunk_length = min(
+            inflate_remaining_body_size,
+            (uint32_t)HTTP_INFLATE_INPUT_CHUNK_SIZE);
+
+        if (!readBodyChunk(inflate_input, chunk_length)) {
+            Log.errorf(F("Failed to read HTTP body with %lu bytes left\r\n"),
+                       inflate_remaining_body_size);
+            inflate_remaining_body_size = 0;
+            return -1;
+        }
+
+        inflate_remaining_body_size -= chunk_length;
+        inflate_input_length   = chunk_length;
+        inflate_input_position = 0;
+    }
+
+    return inflate_input[inflate_input_position++];
+}
+
+InflateResult HttpClientClass::streamInflatedBody(const uint32_t data_size,
+                                                  InflateSink sink,
+                                                  const uint8_t window_bits,
+                                                  uint32_t* inflated_size) {
+
+    static_assert(HTTP_INFLATE_MAX_WINDOW_BITS <= INFLATE_MAX_WINDOW_BITS,
+                  "HTTP_INFLATE_MAX_WINDOW_BITS exceeds the window of the "
+                  "decoder");
+
+    if (window_bits < INFLATE_MIN_WINDOW_BITS ||
+        window_bits > HTTP_INFLATE_MAX_WINDOW_BITS) {
+        return InflateResult::INVALID_ARGUMENT;
+    }
+
+    uint8_t input[HTTP_INFLATE_INPUT_CHUNK_SIZE];
+    uint8_t window[1U << window_bits];
+
+    inflate_input               = input;
+    inflate_input_length        = 0;
+    inflate_input_position      = 0;
+    inflate_remaining_body_size = data_size;
+
+    LedCtrl.on(Led::DATA, true);
+
+    // Fix for bringing the modem out of idling and prevent timeout whilst
+    // waiting for modem response during the next AT command
+    SequansController.writeCommand(F("AT"));
+
+    Inflater inflater(window, window_bits);
+    const InflateResult result = inflater.inflate(readCompressedBodyByte,
+                                                  sink);
+
+    // Read out what is left of the body if the decompression stopped early,
+    // so that it doesn't linger in the modem
+    while (result != InflateResult::OK && readCompressedBodyByte() >= 0) {}
+
+    LedCtrl.off(Led::DATA, true);
+
+    if (result != InflateResult::OK) {
+        Log.errorf(F("Failed to inflate HTTP body, error: %d\r\n"),
+                   static_cast<uint8_t>(result));
+    }
+
+    if (inflated_size != NULL) {
+        *inflated_size = inflater.getOutputLength();
+    }
+
+    return result;
+}
+
+HttpRequestTimings HttpClientClass::getLastRequestTimings(void) {
+    return last_timings;
+}
+
+bool HttpClientClass::getEndpointStatistics(
+    const char* endpoint,
+    HttpEndpointStatistics* statistics) {
+
+    const EndpointStatisticsEntry* entry = findEndpointStatistics(
+        endpointKey(endpoint));
+
+    if (entry == NULL) {
+        return false;
+    }
+
+    *statistics = entry->statistics;
+
+    return true;
+}
+
+void HttpClientClass::clearStatistics(void) {
+    memset(endpoint_statistics, 0, sizeof(endpoint_statistics));
+    num_endpoint_statistics  = 0;
+    next_endpoint_statistics = 0;
+    request_statistics       = NULL;
 }
 
 String HttpClientClass::readBody(const uint32_t size) {
@@ -5,17 +5,158 @@
 #ifndef HTTP_CLIENT_H
 #define HTTP_CLIENT_H
 
+#include "inflate.h"
+
 #include <Arduino.h>
 #include <stdint.h>
 
 #define HTTP_DEFAULT_TIMEOUT_MS (30000U)
 
+/**
+ * @brief Default size of the chunks HttpClientClass::streamBody() reads the
+ * body in, and the size of the chunks requested from a HttpDataProducer. This
+ * is also the amount of RAM used for the body.
+ */
+#define HTTP_STREAM_CHUNK_SIZE (256)
+
 typedef struct {
     uint16_t status_code;
     uint32_t data_size;
     uint16_t curl_error_code;
 } HttpResponse;
 
+/**
+ * @brief Produces the payload of a streamed upload. Called repeatedly until the
+ * whole payload has been delivered.
+ *
+ * @param chunk Destination of the data.
+ * @param chunk_size Maximum amount of bytes to place in @p chunk.
+ * @param offset Offset of the chunk within the payload.
+ *
+ * @return The number of bytes placed in @p chunk. 0 aborts the upload.
+ */
+typedef uint16_t (*HttpDataProducer)(uint8_t* chunk,
+                                     const uint16_t chunk_size,
+                                     const uint32_t offset);
+
+/**
+ * @brief Number of endpoints which can be enabled for conditional requests,
+ * see HttpClientClass::enableConditionalRequests().
+ */
+#define HTTP_VALIDATOR_CACHE_SIZE (4)
+
+/**
+ * @brief Maximum length of the content type captured from the response, see
+ * HttpClientClass::getLastContentType().
+ */
+#define HTTP_CONTENT_TYPE_MAX_LENGTH (48)
+
+/**
+ * @brief Number of HTTP profiles used in the modem. Profile 0 is used by
+ * HttpClientClass::configure(), the rest can be opened with
+ * HttpClientClass::openProfile().
+ */
+#define HTTP_MAX_PROFILES (3)
+
+/**
+ * @brief Default window of HttpClientClass::streamInflatedBody(), given as the
+ * base-two logarithm of the amount of bytes (1 kB).
+ */
+#define HTTP_INFLATE_DEFAULT_WINDOW_BITS (10)
+
+/**
+ * @brief Largest window accepted by HttpClientClass::streamInflatedBody(). The
+ * window is allocated on the stack, and larger windows (8 kB and up) don't fit
+ * in the RAM of the AVR128DB48.
+ */
+#define HTTP_INFLATE_MAX_WINDOW_BITS (12)
+
+/**
+ * @brief Header to pass to HttpClientClass::get() to ask the server for a
+ * compressed body.
+ */
+#define HTTP_ACCEPT_ENCODING_HEADER "Accept-Encoding: gzip, deflate"
+
+/**
+ * @brief Number of endpoints statistics are kept for, see
+ * HttpClientClass::getEndpointStatistics(). The oldest entry is replaced when
+ * the table is full.
+ */
+#define HTTP_STATISTICS_MAX_ENDPOINTS (4)
+
+/**
+ * @brief Number of buckets in the response time histogram. Bucket i counts
+ * the responses which arrived within HTTP_HISTOGRAM_FIRST_BUCKET_MS << i, and
+ * the last bucket the ones which were slower.
+ */
+#define HTTP_HISTOGRAM_BUCKETS         (8)
+#define HTTP_HISTOGRAM_FIRST_BUCKET_MS (250UL)
+
+/**
+ * @brief Breakdown of the last request. The phases are given as the time
+ * since the request was started, and are zero if the request did not get
+ * that far.
+ */
+typedef struct {
+    /**
+     * @brief The modem accepted the command. For requests with a payload,
+     * this is when the command was written, as the modem doesn't respond
+     * until the payload has been sent.
+     */
+    uint32_t command_ms;
+
+    /**
+     * @brief The modem asked for the payload. Only for POST and PUT.
+     */
+    uint32_t payload_prompt_ms;
+
+    /**
+     * @brief The payload was written to the modem. Only for POST and PUT.
+     */
+    uint32_t payload_sent_ms;
+
+    /**
+     * @brief The response (SQNHTTPRING) arrived.
+     */
+    uint32_t response_ms;
+
+    /**
+     * @brief The last read of the body was done.
+     */
+    uint32_t body_read_ms;
+
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+
+    /**
+     * @brief Number of AT+SQNHTTPRCV commands used to read the body.
+     */
+    uint16_t receive_round_trips;
+} HttpRequestTimings;
+
+/**
+ * @brief Aggregated statistics for the requests to one endpoint.
+ */
+typedef struct {
+    uint16_t requests;
+
+    /**
+     * @brief Requests which did not get a response or where the connection
+     * failed.
+     */
+    uint16_t failures;
+
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+    uint32_t receive_round_trips;
+
+    /**
+     * @brief Histogram of the time until the response arrived, see
+     * #HTTP_HISTOGRAM_BUCKETS.
+     */
+    uint16_t response_histogram[HTTP_HISTOGRAM_BUCKETS];
+} HttpEndpointStatistics;
+
 class HttpClientClass {
 
   private:
@@ -29,6 +170,8 @@ class HttpClientClass {
 
     enum StatusCodes {
         STATUS_OK                    = 200,
+        STATUS_PARTIAL_CONTENT       = 206,
+        STATUS_NOT_MODIFIED          = 304,
         STATUS_NOT_FOUND             = 404,
         STATUS_INTERNAL_SERVER_ERROR = 500,
     };
@@ -54,6 +197,41 @@ class HttpClientClass {
     bool
     configure(const char* host, const uint16_t port, const bool enable_tls);
 
+    /**
+     * @brief Opens a profile for a host, so that requests can alternate
+     * between several hosts without reconfiguring the modem for every
+     * request. If a profile is already open for the same host, port and TLS
+     * setting, it is reused without any communication with the modem.
+     *
+     * @param host Same as for configure().
+     * @param port Same as for configure().
+     * @param enable_tls Same as for configure().
+     *
+     * @return Handle of the profile, to be passed to useProfile(), or -1 if
+     * there was no free profile or it could not be configured.
+     */
+    int8_t
+    openProfile(const char* host, const uint16_t port, const bool enable_tls);
+
+    /**
+     * @brief Selects the profile the following requests are issued to. The
+     * profile set up with configure() is selected with handle 0.
+     *
+     * @return False if the handle does not refer to a configured profile.
+     */
+    bool useProfile(const int8_t handle);
+
+    /**
+     * @brief Frees a profile opened with openProfile().
+     */
+    void closeProfile(const int8_t handle);
+
+    /**
+     * @brief Forgets all the profile configurations. Called when the modem is
+     * powered down, as it might not keep them.
+     */
+    void end(void);
+
     /**
      * @brief Issues a post to the host configured. Will block until operation
      * is done.
@@ -94,6 +272,33 @@ class HttpClientClass {
                       const ContentType content_type = CONTENT_TYPE_TEXT_PLAIN,
                       const uint32_t timeout_ms      = HTTP_DEFAULT_TIMEOUT_MS);
 
+    /**
+     * @brief Issues a post to the host configured where the payload is
+     * requested from @p producer in chunks after the modem is ready for it, so
+     * that the payload doesn't have to be held in RAM. Will block until
+     * operation is done.
+     *
+     * @param endpoint Endpoint to issue the POST to. Is the part of the URL
+     * after the domain.
+     * @param data_length The total length of the payload.
+     * @param producer Called for every chunk of the payload.
+     * @param header Optional header line (e.g. for authorization
+     * bearers).
+     * @param content_type HTTP content type of the post request.
+     * @param timeout_ms Timeout in milliseconds to wait for the POST request.
+     *
+     * @note If the producer aborts, the rest of the payload is padded with
+     * zeros as the length is already given to the modem, and a response with
+     * status code 0 is returned.
+     */
+    HttpResponse post(const char* endpoint,
+                      const uint32_t data_length,
+                      HttpDataProducer producer,
+                      const char* header = NULL,
+                      const ContentType content_type =
+                          CONTENT_TYPE_APPLICATION_OCTET_STREAM,
+                      const uint32_t timeout_ms = HTTP_DEFAULT_TIMEOUT_MS);
+
     /**
      * @brief Issues a put to the host configured. Will block until operation is
      * done.
@@ -130,6 +335,25 @@ class HttpClientClass {
                      const char* header        = NULL,
                      const uint32_t timeout_ms = HTTP_DEFAULT_TIMEOUT_MS);
 
+    /**
+     * @brief Issues a put to the host configured where the payload is
+     * requested from @p producer in chunks, see the streaming version of
+     * #post(). Will block until operation is done.
+     *
+     * @param endpoint Endpoint to issue the PUT to. Is the part of the URL
+     * after the domain.
+     * @param data_length The total length of the payload.
+     * @param producer Called for every chunk of the payload.
+     * @param header Optional header line (e.g. for authorization
+     * bearers).
+     * @param timeout_ms Timeout in milliseconds to wait for the PUT request.
+     */
+    HttpResponse put(const char* endpoint,
+                     const uint32_t data_length,
+                     HttpDataProducer producer,
+                     const char* header        = NULL,
+                     const uint32_t timeout_ms = HTTP_DEFAULT_TIMEOUT_MS);
+
     /**
      * @brief Issues a get from the host configured. Will block until operation
      * is done. The contents of the body after the get can be read using the
@@ -140,11 +364,63 @@ class HttpClientClass {
      * @param header Optional header line (e.g. for authorization
      * bearers).
      * @param timeout_ms Timeout in milliseconds to wait for the GET request.
+     *
+     * @note Only endpoints enabled with #enableConditionalRequests() are
+     * requested with If-Modified-Since, and then STATUS_NOT_MODIFIED (304)
+     * might be returned. See there for when this can miss a change.
      */
     HttpResponse get(const char* endpoint,
                      const char* header        = NULL,
                      const uint32_t timeout_ms = HTTP_DEFAULT_TIMEOUT_MS);
 
+    /**
+     * @brief Makes GET requests of @p endpoint conditional. Other endpoints
+     * are not affected. When the endpoint has been fetched before with status
+     * code 200, the next GET of it carries an If-Modified-Since header with
+     * the time of the previous fetch. If the resource has not changed, the
+     * server answers with STATUS_NOT_MODIFIED (304) and no body, which saves
+     * both data and time with the radio on.
+     *
+     * The modem does not give access to the response headers, so ETag and
+     * Last-Modified from the server can't be used as validators. The time of
+     * the previous fetch is taken from the modem's network synchronised clock
+     * instead. This has some limits, so only enable it for servers where they
+     * are known to be acceptable:
+     * - Servers which only answer 304 when the date matches Last-Modified
+     * exactly, such as nginx with its default "if_modified_since exact", will
+     * never answer 304, so nothing is saved.
+     * - If the clock of the device is ahead of the clock of the server, a
+     * resource modified within that difference after the previous fetch is
+     * regarded as not modified by the server, and the change is missed until
+     * the resource is modified again.
+     * - GET requests which pass a header of their own are not made
+     * conditional, as the modem only takes one extra header line.
+     *
+     * @param endpoint The part of the URL after the host name.
+     *
+     * @return false if #HTTP_VALIDATOR_CACHE_SIZE endpoints are enabled
+     * already.
+     */
+    bool enableConditionalRequests(const char* endpoint);
+
+    /**
+     * @brief Makes GET requests of @p endpoint unconditional again.
+     */
+    void disableConditionalRequests(const char* endpoint);
+
+    /**
+     * @brief Forgets the previous fetches used for conditional requests, so
+     * that the next GET of every enabled endpoint is unconditional. The
+     * endpoints stay enabled.
+     */
+    void clearValidators(void);
+
+    /**
+     * @return The content type of the last response, e.g. "application/json".
+     * Empty if the modem did not report one.
+     */
+    const char* getLastContentType(void);
+
     /**
      * @brief Issues a head from the host configured. Will block until operation
      * is done.
@@ -196,6 +472,73 @@ class HttpClientClass {
      * @param size How many bytes to read at a time.
      */
     String readBody(const uint32_t size = 256);
+
+    /**
+     * @brief Reads the whole body of the response after a HTTP call in chunks
+     * and passes them on to @p sink in order, so that bodies larger than what
+     * fits in RAM can be processed, e.g. written to flash.
+     *
+     * @param data_size The size of the body, as given in the HttpResponse.
+     * @param sink Called with every chunk of the body and the offset of the
+     * chunk within the body.
+     * @param chunk_size Size of the chunks, has to be between 64-1500.
+     *
+     * @return The number of bytes passed to @p sink. Less than @p data_size if
+     * the body could not be read completely.
+     */
+    uint32_t streamBody(const uint32_t data_size,
+                        void (*sink)(const uint8_t* chunk,
+                                     const uint16_t chunk_length,
+                                     const uint32_t offset),
+                        const uint16_t chunk_size = HTTP_STREAM_CHUNK_SIZE);
+
+    /**
+     * @brief Same as streamBody(), but a gzip or zlib compressed body is
+     * decompressed on the way to @p sink. Ask for compression by passing
+     * #HTTP_ACCEPT_ENCODING_HEADER as the header to get(). A body which isn't
+     * compressed is passed on unchanged.
+     *
+     * The window is allocated on the stack, so the server has to compress with
+     * a window no larger than @p window_bits, e.g. with zlib's windowBits, to
+     * keep the RAM usage down.
+     *
+     * @param data_size The size of the (compressed) body, as given in the
+     * HttpResponse.
+     * @param sink Called with the decompressed data and its offset in the
+     * decompressed body.
+     * @param window_bits Base-two logarithm of the window size, between
+     * #INFLATE_MIN_WINDOW_BITS and #HTTP_INFLATE_MAX_WINDOW_BITS.
+     * @param inflated_size Optional destination of the amount of decompressed
+     * bytes passed to @p sink.
+     *
+     * @return InflateResult::OK if the whole body was decompressed and its
+     * checksum matched.
+     */
+    InflateResult streamInflatedBody(
+        const uint32_t data_size,
+        InflateSink sink,
+        const uint8_t window_bits = HTTP_INFLATE_DEFAULT_WINDOW_BITS,
+        uint32_t* inflated_size   = NULL);
+
+    /**
+     * @return Timing breakdown and transfer sizes of the last request,
+     * including the reads of its body done so far.
+     */
+    HttpRequestTimings getLastRequestTimings(void);
+
+    /**
+     * @brief Retrieves the statistics aggregated for @p endpoint on the active
+     * profile.
+     *
+     * @return false if there are no statistics for the endpoint.
+     */
+    bool getEndpointStatistics(const char* endpoint,
+                               HttpEndpointStatistics* statistics);
+
+    /**
+     * @brief Clears the statistics of all endpoints.
+     */
+    void clearStatistics(void);
 };
 
 extern HttpClientClass HttpClient;
@@ -0,0 +1,367 @@
+#include "http_download.h"
+#include "crc32.h"
+#include "ecc608.h"
+#include "http_client.h"
+#include "log.h"
+#include "lte.h"
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SHA256_BLOCK_SIZE (64)
+
+// Fits "Range: bytes=4294967295-4294967295"
+#define RANGE_HEADER_LENGTH (36)
+
+HttpDownloadClass HttpDownload = HttpDownloadClass::instance();
+
+/**
+ * @brief The download progress, laid out as it is persisted in EEPROM. The
+ * SHA-256 context is read out of the ECC after every block, so that the hash
+ * can be continued after a power down.
+ */
+typedef struct {
+    uint32_t image_id;
+    uint32_t offset;
+    uint32_t crc32;
+    uint16_t sha_context_size;
+    uint8_t sha_context[SHA_CONTEXT_MAX_SIZE];
+
+    // Guards against a record which was only partially written
+    uint32_t record_crc32;
+} DownloadProgress;
+
+static_assert(sizeof(DownloadProgress) <= EEPROM_LAYOUT_HTTP_DOWNLOAD_SIZE,
+              "The download progress doesn't fit in its space in EEPROM");
+
+static DownloadProgress progress;
+
+static HttpDownloadSink user_sink = NULL;
+static uint32_t block_offset      = 0;
+static uint32_t block_crc32       = 0;
+static bool hash_enabled          = false;
+static bool hash_failed           = false;
+
+static uint8_t hash_pending[SHA256_BLOCK_SIZE];
+static uint8_t hash_pending_length = 0;
+
+static uint32_t last_crc32 = 0;
+
+static uint32_t progressRecordCrc32(const DownloadProgress* record) {
+    return crc32Update(CRC32_INITIAL_VALUE,
+                       (const uint8_t*)record,
+                       offsetof(DownloadProgress, record_crc32));
+}
+
+/**
+ * @brief Identifies the endpoint and image, so that the progress of a
+ * download is not continued with a different file.
+ */
+static uint32_t imageId(const char* endpoint, const HttpDownloadImage& image) {
+
+    uint32_t id = crc32Update(CRC32_INITIAL_VALUE,
+                              (const uint8_t*)endpoint,
+                              strlen(endpoint));
+
+    id = crc32Update(id, (const uint8_t*)&image.size, sizeof(image.size));
+
+    if (image.verify_crc32) {
+        id = crc32Update(id, (const uint8_t*)&image.crc32, sizeof(image.crc32));
+    }
+
+    if (image.verify_sha256) {
+        id = crc32Update(id, image.sha256, sizeof(image.sha256));
+    }
+
+    return id;
+}
+
+/**
+ * @brief Loads the persisted progress for @p image_id, or starts from the
+ * beginning if there is none.
+ */
+static void loadProgress(const uint32_t image_id) {
+
+    eeprom_read_block(&progress,
+                      (const void*)HTTP_DOWNLOAD_EEPROM_ADDRESS,
+                      sizeof(progress));
+
+    if (progress.record_crc32 != progressRecordCrc32(&progress) ||
+        progress.image_id != image_id ||
+        progress.sha_context_size > sizeof(progress.sha_context)) {
+        memset(&progress, 0, sizeof(progress));
+        progress.image_id = image_id;
+        progress.crc32    = CRC32_INITIAL_VALUE;
+    }
+}
+
+static void persistProgress(void) {
+    progress.record_crc32 = progressRecordCrc32(&progress);
+
+    // Only the bytes which have changed are written, which limits the wear
+    eeprom_update_block(&progress,
+                        (void*)HTTP_DOWNLOAD_EEPROM_ADDRESS,
+                        sizeof(progress));
+}
+
+/**
+ * @brief Puts the SHA-256 calculation in the ECC back to where the persisted
+ * progress is, which is also done when a block is retried.
+ */
+static bool restoreHash(void) {
+
+    hash_pending_length = 0;
+    hash_failed         = false;
+
+    if (!hash_enabled) {
+        return true;
+    }
+
+    const ATCA_STATUS status =
+        progress.offset == 0
+            ? atcab_sha_start()
+            : atcab_sha_write_context(progress.sha_context,
+                                      progress.sha_context_size);
+
+    hash_failed = status != ATCA_SUCCESS;
+
+    return !hash_failed;
+}
+
+/**
+ * @brief Feeds the ECC with @p data. The ECC only takes whole SHA-256 blocks
+ * until the end, so what is left over is kept until the next call.
+ */
+static void updateHash(const uint8_t* data, uint16_t length) {
+
+    while (length > 0 && !hash_failed) {
+        const uint16_t amount = min(
+            length,
+            (uint16_t)(SHA256_BLOCK_SIZE - hash_pending_length));
+
+        memcpy(&hash_pending[hash_pending_length], data, amount);
+        hash_pending_length += amount;
+        data += amount;
+        length -= amount;
+
+        if (hash_pending_length == SHA256_BLOCK_SIZE) {
+            hash_failed = atcab_sha_update(hash_pending) != ATCA_SUCCESS;
+            hash_pending_length = 0;
+        }
+    }
+}
+
+static void blockSink(const uint8_t* data,
+                      const uint16_t length,
+                      const uint32_t offset) {
+
+    block_crc32 = crc32Update(block_crc32, data, length);
+
+    if (hash_enabled) {
+        updateHash(data, length);
+    }
+
+    user_sink(data, length, block_offset + offset);
+}
+
+/**
+ * @brief Requests the block at the current offset and passes it on.
+ *
+ * @return The length of the block or 0 if it could not be fetched.
+ * @p range_not_supported is set if the server does not support range
+ * requests.
+ */
+static uint32_t fetchBlock(const char* endpoint,
+                           const uint32_t size,
+                           const uint16_t block_size,
+                           bool* range_not_supported) {
+
+    const uint32_t length = min(size - progress.offset, (uint32_t)block_size);
+
+    char range_header[RANGE_HEADER_LENGTH] = "";
+    snprintf_P(range_header,
+               sizeof(range_header),
+               PSTR("Range: bytes=%lu-%lu"),
+               (unsigned long)progress.offset,
+               (unsigned long)(progress.offset + length - 1));
+
+    const HttpResponse response = HttpClient.get(endpoint, range_header);
+
+    uint32_t expected_length = length;
+
+    if (response.status_code == HttpClientClass::STATUS_OK) {
+
+        // The server ignored the range and sent the whole file, which is
+        // still fine at the beginning
+        if (progress.offset != 0 || response.data_size != size) {
+            *range_not_supported = true;
+            return 0;
+        }
+
+        expected_length = size;
+    } else if (response.status_code !=
+               HttpClientClass::STATUS_PARTIAL_CONTENT) {
+        Log.warnf(F("Range request at %lu failed with status %u\r\n"),
+                  progress.offset,
+                  response.status_code);
+        return 0;
+    }
+
+    if (response.data_size != expected_length) {
+        Log.warnf(F("Got %lu bytes for a block of %lu bytes at %lu\r\n"),
+                  response.data_size,
+                  expected_length,
+                  progress.offset);
+        return 0;
+    }
+
+    block_offset = progress.offset;
+    block_crc32  = progress.crc32;
+
+    if (!restoreHash()) {
+        return 0;
+    }
+
+    if (HttpClient.streamBody(response.data_size, blockSink) !=
+        expected_length) {
+        return 0;
+    }
+
+    return expected_length;
+}
+
+/**
+ * @brief Finishes the SHA-256 and compares it with the expected digest.
+ */
+static HttpDownloadResult verifyHash(const HttpDownloadImage& image) {
+
+    uint8_t digest[ATCA_SHA256_DIGEST_SIZE];
+
+    if (hash_failed || atcab_sha_end(digest,
+                                     hash_pending_length,
+                                     hash_pending) != ATCA_SUCCESS) {
+        return HttpDownloadResult::HASH_ERROR;
+    }
+
+    if (memcmp(digest, image.sha256, sizeof(digest)) != 0) {
+        Log.error(F("SHA-256 of the download did not match"));
+        return HttpDownloadResult::VERIFICATION_FAILED;
+    }
+
+    return HttpDownloadResult::OK;
+}
+
+HttpDownloadResult HttpDownloadClass::download(const char* endpoint,
+                                               const HttpDownloadImage& image,
+                                               HttpDownloadSink sink,
+                                               const uint16_t block_size) {
+
+    if (sink == NULL || image.size == 0 || block_size == 0 ||
+        block_size % SHA256_BLOCK_SIZE != 0) {
+        return HttpDownloadResult::INVALID_ARGUMENT;
+    }
+
+    user_sink    = sink;
+    hash_enabled = image.verify_sha256;
+
+    loadProgress(imageId(endpoint, image));
+
+    if (progress.offset > 0) {
+        Log.infof(F("Resuming download of %s at %lu of %lu bytes\r\n"),
+                  endpoint,
+                  progress.offset,
+                  image.size);
+    }
+
+    if (hash_enabled && ECC608.begin() != ATCA_SUCCESS) {
+        return HttpDownloadResult::HASH_ERROR;
+    }
+
+    while (progress.offset < image.size) {
+
+        uint32_t block_length    = 0;
+        bool range_not_supported = false;
+
+        for (uint8_t attempt = 0;
+             attempt < HTTP_DOWNLOAD_MAX_ATTEMPTS && block_length == 0;
+             attempt++) {
+
+            if (!Lte.isConnected()) {
+                Log.warn(F("Download interrupted, not connected"));
+                return HttpDownloadResult::INTERRUPTED;
+            }
+
+            block_length = fetchBlock(endpoint,
+                                      image.size,
+                                      block_size,
+                                      &range_not_supported);
+
+            if (range_not_supported) {
+                Log.error(F("The server does not support range requests"));
+                return HttpDownloadResult::RANGE_NOT_SUPPORTED;
+            }
+
+            if (hash_failed) {
+                return HttpDownloadResult::HASH_ERROR;
+            }
+        }
+
+        if (block_length == 0) {
+            return HttpDownloadResult::INTERRUPTED;
+        }
+
+        progress.offset += block_length;
+        progress.crc32 = block_crc32;
+
+        // The last block is verified right away, so there is no need to
+        // persist the hash of it, which could be a partial SHA-256 block
+        if (progress.offset < image.size) {
+            if (hash_enabled) {
+                progress.sha_context_size = sizeof(progress.sha_context);
+
+                if (atcab_sha_read_context(progress.sha_context,
+                                           &progress.sha_context_size) !=
+                    ATCA_SUCCESS) {
+                    return HttpDownloadResult::HASH_ERROR;
+                }
+            }
+
+            persistProgress();
+        }
+    }
+
+    last_crc32 = ~progress.crc32;
+
+    HttpDownloadResult result = HttpDownloadResult::OK;
+
+    if (image.verify_crc32 && last_crc32 != image.crc32) {
+        Log.error(F("CRC-32 of the download did not match"));
+        result = HttpDownloadResult::VERIFICATION_FAILED;
+    } else if (hash_enabled) {
+        result = verifyHash(image);
+    }
+
+    // A corrupted download is not resumed, but fetched from the beginning the
+    // next time
+    if (result != HttpDownloadResult::HASH_ERROR) {
+        clearProgress();
+    }
+
+    return result;
+}
+
+uint32_t HttpDownloadClass::getProgress(const char* endpoint,
+                                        const HttpDownloadImage& image) {
+    loadProgress(imageId(endpoint, image));
+    return progress.offset;
+}
+
+uint32_t HttpDownloadClass::getCrc32(void) { return last_crc32; }
+
+void HttpDownloadClass::clearProgress(void) {
+    memset(&progress, 0, sizeof(progress));
+    persistProgress();
+}
@@ -0,0 +1,123 @@
+/**
+ * @brief Resumable download of large files over HTTP, e.g. firmware images,
+ * built on HttpClient. The file is fetched in blocks with range requests and
+ * the progress is persisted in EEPROM, so that a download interrupted by a
+ * lost connection or a power down continues where it left off.
+ */
+
+#ifndef HTTP_DOWNLOAD_H
+#define HTTP_DOWNLOAD_H
+
+#include "eeprom_layout.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * @brief Default size of the blocks requested with each range request. Has to
+ * be a multiple of 64 bytes, the block size of SHA-256.
+ */
+#define HTTP_DOWNLOAD_BLOCK_SIZE (4096)
+
+/**
+ * @brief Number of times a block is requested before the download is
+ * considered interrupted.
+ */
+#define HTTP_DOWNLOAD_MAX_ATTEMPTS (3)
+
+/**
+ * @brief Describes the file to download, typically taken from a manifest.
+ */
+typedef struct {
+    uint32_t size;
+    bool verify_crc32;
+    uint32_t crc32;
+    bool verify_sha256;
+    uint8_t sha256[32];
+} HttpDownloadImage;
+
+enum class HttpDownloadResult {
+    OK = 0,
+
+    // A block could not be fetched. The progress is kept, so the download can
+    // be resumed by calling HttpDownloadClass::download() again.
+    INTERRUPTED,
+
+    // The server does not support range requests
+    RANGE_NOT_SUPPORTED,
+
+    // The CRC-32 or SHA-256 of the downloaded file did not match. The progress
+    // is cleared.
+    VERIFICATION_FAILED,
+
+    // The ECC failed to calculate the SHA-256
+    HASH_ERROR,
+
+    INVALID_ARGUMENT
+};
+
+/**
+ * @brief Receives the downloaded data. The same range might be passed on more
+ * than once if a block is retried, but always at the same offset.
+ *
+ * @param data The data.
+ * @param length Amount of bytes in @p data.
+ * @param offset Offset of @p data within the file.
+ */
+typedef void (*HttpDownloadSink)(const uint8_t* data,
+                                 const uint16_t length,
+                                 const uint32_t offset);
+
+class HttpDownloadClass {
+
+  private:
+    HttpDownloadClass(){};
+
+  public:
+    static HttpDownloadClass& instance(void) {
+        static HttpDownloadClass instance;
+        return instance;
+    }
+
+    /**
+     * @brief Downloads @p endpoint from the host configured in HttpClient in
+     * blocks. If the progress of a previous download of the same endpoint and
+     * image was persisted, the download continues from there. Each block is
+     * checked to be of the length requested before the progress is persisted.
+     * The CRC-32 of the whole file is calculated on the way and the SHA-256 on
+     * the ECC, and they are verified against @p image at the end. Will block
+     * until the download is done or interrupted.
+     *
+     * @param endpoint The part of the URL after the host name.
+     * @param image Size and expected checksums of the file.
+     * @param sink Called with every chunk of the file.
+     * @param block_size Amount of bytes to request at a time, has to be a
+     * multiple of 64.
+     */
+    HttpDownloadResult
+    download(const char* endpoint,
+             const HttpDownloadImage& image,
+             HttpDownloadSink sink,
+             const uint16_t block_size = HTTP_DOWNLOAD_BLOCK_SIZE);
+
+    /**
+     * @return Amount of bytes of @p endpoint and @p image which have been
+     * downloaded and persisted, so that they won't be fetched again.
+     */
+    uint32_t getProgress(const char* endpoint, const HttpDownloadImage& image);
+
+    /**
+     * @return The CRC-32 of the file from the last completed download.
+     */
+    uint32_t getCrc32(void);
+
+    /**
+     * @brief Clears the persisted progress, so that the next download starts
+     * from the beginning.
+     */
+    void clearProgress(void);
+};
+
+extern HttpDownloadClass HttpDownload;
+
+#endif
@@ -0,0 +1,294 @@
+#include "http_spool.h"
+#include "http_client.h"
+#include "log.h"
+#include "low_power.h"
+#include "lte.h"
+#include "lte_signal.h"
+
+#include <string.h>
+
+#define LENGTH_PREFIX_SIZE (2)
+
+HttpSpoolClass HttpSpool = HttpSpoolClass::instance();
+
+static bool spool_enabled = false;
+
+static char spool_endpoint[HTTP_SPOOL_ENDPOINT_LENGTH] = "";
+static HttpSpoolFormat spool_format = HttpSpoolFormat::NEWLINE_DELIMITED;
+static uint16_t spool_flush_size    = HTTP_SPOOL_FLUSH_SIZE;
+static uint32_t spool_max_age_ms    = HTTP_SPOOL_MAX_AGE_MS;
+
+/**
+ * @brief Ring holding the records as they are sent, with their separators, so
+ * that the body can be produced straight from it.
+ */
+static uint8_t spool_ring[HTTP_SPOOL_SIZE];
+static uint16_t spool_ring_tail = 0;
+static uint16_t spool_ring_used = 0;
+static uint16_t spool_records   = 0;
+
+/**
+ * @brief Time when the oldest record in the spool was appended.
+ */
+static uint32_t spool_oldest_ms = 0;
+
+static uint32_t dropped_records  = 0;
+static uint16_t last_status_code = 0;
+
+static bool defer_on_weak_signal = false;
+
+static uint16_t spoolRingIndex(const uint16_t index, const uint16_t offset) {
+    const uint16_t ring_index = index + offset;
+
+    return ring_index >= HTTP_SPOOL_SIZE ? ring_index - HTTP_SPOOL_SIZE
+                                         : ring_index;
+}
+
+static void
+spoolRingWrite(const uint16_t index, const uint8_t* data, const uint16_t size) {
+    for (uint16_t i = 0; i < size; i++) {
+        spool_ring[spoolRingIndex(index, i)] = data[i];
+    }
+}
+
+/**
+ * @return The size of the oldest record in the ring, including its separator.
+ */
+static uint16_t oldestRecordSize(void) {
+
+    if (spool_format == HttpSpoolFormat::LENGTH_PREFIXED) {
+        return LENGTH_PREFIX_SIZE +
+               ((spool_ring[spool_ring_tail] << 8) |
+                spool_ring[spoolRingIndex(spool_ring_tail, 1)]);
+    }
+
+    uint16_t size = 0;
+
+    while (size < spool_ring_used &&
+           spool_ring[spoolRingIndex(spool_ring_tail, size)] != '\n') {
+        size++;
+    }
+
+    return size + 1;
+}
+
+static void dropOldestRecord(void) {
+    const uint16_t size = oldestRecordSize();
+
+    spool_ring_tail = spoolRingIndex(spool_ring_tail, size);
+    spool_ring_used -= size;
+    spool_records--;
+    dropped_records++;
+}
+
+/**
+ * @brief Produces the body of the flush straight from the ring.
+ */
+static uint16_t spoolProducer(uint8_t* chunk,
+                              const uint16_t chunk_size,
+                              const uint32_t offset) {
+
+    const uint16_t length = min((uint32_t)chunk_size,
+                                (uint32_t)spool_ring_used - offset);
+
+    for (uint16_t i = 0; i < length; i++) {
+        chunk[i] = spool_ring[spoolRingIndex(spool_ring_tail, offset + i)];
+    }
+
+    return length;
+}
+
+/**
+ * @brief Sends the spooled records before sleeping, so that they don't wait
+ * for a whole power save period.
+ */
+static void flushBeforeSleep(void) { HttpSpool.flush(); }
+
+bool HttpSpoolClass::begin(const char* endpoint,
+                           const HttpSpoolFormat format,
+                           const uint16_t flush_size,
+                           const uint32_t max_age_ms) {
+
+    if (strlen(endpoint) >= sizeof(spool_endpoint)) {
+        Log.error(F("The endpoint for the HTTP spool is too long"));
+        return false;
+    }
+
+    strcpy(spool_endpoint, endpoint);
+
+    spool_format     = format;
+    spool_flush_size = min(flush_size, (uint16_t)HTTP_SPOOL_SIZE);
+    spool_max_age_ms = max_age_ms;
+
+    spool_ring_tail  = 0;
+    spool_ring_used  = 0;
+    spool_records    = 0;
+    dropped_records  = 0;
+    last_status_code = 0;
+    spool_enabled    = true;
+
+    LowPower.registerPreSleepCallback(flushBeforeSleep);
+
+    return true;
+}
+
+void HttpSpoolClass::end(void) {
+    spool_enabled   = false;
+    spool_ring_used = 0;
+    spool_records   = 0;
+
+    LowPower.unregisterPreSleepCallback(flushBeforeSleep);
+}
+
+bool HttpSpoolClass::append(const uint8_t* record, const uint16_t length) {
+
+    if (!spool_enabled) {
+        return false;
+    }
+
+    const uint16_t separator_size =
+        spool_format == HttpSpoolFormat::LENGTH_PREFIXED ? LENGTH_PREFIX_SIZE
+                                                         : 1;
+
+    if (length > HTTP_SPOOL_SIZE - separator_size) {
+        Log.warnf(F("Record of %u bytes does not fit in the HTTP spool\r\n"),
+                  length);
+        return false;
+    }
+
+    if (spool_format == HttpSpoolFormat::NEWLINE_DELIMITED &&
+        memchr(record, '\n', length) != NULL) {
+        Log.warn(F("Records in a newline delimited spool can't contain "
+                   "newlines"));
+        return false;
+    }
+
+    while (length + separator_size > HTTP_SPOOL_SIZE - spool_ring_used) {
+        dropOldestRecord();
+    }
+
+    if (spool_records == 0) {
+        spool_oldest_ms = millis();
+    }
+
+    uint16_t index = spoolRingIndex(spool_ring_tail, spool_ring_used);
+
+    if (spool_format == HttpSpoolFormat::LENGTH_PREFIXED) {
+        const uint8_t prefix[LENGTH_PREFIX_SIZE] = {(uint8_t)(length >> 8),
+                                                    (uint8_t)(length & 0xFF)};
+        spoolRingWrite(index, prefix, sizeof(prefix));
+        index = spoolRingIndex(index, sizeof(prefix));
+    }
+
+    spoolRingWrite(index, record, length);
+
+    if (spool_format == HttpSpoolFormat::NEWLINE_DELIMITED) {
+        const uint8_t newline = '\n';
+        spoolRingWrite(spoolRingIndex(index, length), &newline, 1);
+    }
+
+    spool_ring_used += length + separator_size;
+    spool_records++;
+
+    return true;
+}
+
+bool HttpSpoolClass::append(const char* record) {
+    return append((const uint8_t*)record, strlen(record));
+}
+
+bool HttpSpoolClass::isFlushDue(void) {
+
+    if (!spool_enabled || spool_records == 0) {
+        return false;
+    }
+
+    return spool_ring_used >= spool_flush_size ||
+           (spool_max_age_ms != 0 &&
+            millis() - spool_oldest_ms >= spool_max_age_ms);
+}
+
+/**
+ * @return true if a due flush can't be deferred any longer.
+ */
+static bool isFlushOverdue(void) {
+    return spool_ring_used >= HTTP_SPOOL_SIZE - HTTP_SPOOL_SIZE / 4 ||
+           (spool_max_age_ms != 0 &&
+            millis() - spool_oldest_ms >= 2 * spool_max_age_ms);
+}
+
+bool HttpSpoolClass::poll(void) {
+
+    if (!isFlushDue()) {
+        return true;
+    }
+
+    if (defer_on_weak_signal && !isFlushOverdue()) {
+        LteSignal.poll();
+
+        if (!LteSignal.isGoodTimeToTransmit()) {
+            return true;
+        }
+    }
+
+    return flush();
+}
+
+void HttpSpoolClass::deferOnWeakSignal(const bool enable) {
+    defer_on_weak_signal = enable;
+}
+
+bool HttpSpoolClass::flush(void) {
+
+    if (!spool_enabled || spool_records == 0) {
+        return true;
+    }
+
+    if (!Lte.isConnected()) {
+        return false;
+    }
+
+    const HttpClientClass::ContentType content_type =
+        spool_format == HttpSpoolFormat::LENGTH_PREFIXED
+            ? HttpClientClass::CONTENT_TYPE_APPLICATION_OCTET_STREAM
+            : HttpClientClass::CONTENT_TYPE_TEXT_PLAIN;
+
+    // Nothing is appended whilst the request is in progress, so what is posted
+    // is exactly what is in the ring now
+    const uint16_t records = spool_records;
+    const uint16_t size    = spool_ring_used;
+
+    const HttpResponse response = HttpClient.post(spool_endpoint,
+                                                  size,
+                                                  spoolProducer,
+                                                  NULL,
+                                                  content_type);
+
+    last_status_code = response.status_code;
+
+    if (response.status_code < 200 || response.status_code >= 300) {
+        Log.warnf(F("Failed to flush %u records from the HTTP spool, status "
+                    "code %u\r\n"),
+                  records,
+                  response.status_code);
+        return false;
+    }
+
+    spool_ring_tail = spoolRingIndex(spool_ring_tail, size);
+    spool_ring_used -= size;
+    spool_records -= records;
+
+    Log.debugf(F("Flushed %u records (%u bytes) from the HTTP spool\r\n"),
+               records,
+               size);
+
+    return true;
+}
+
+uint16_t HttpSpoolClass::getPendingRecords(void) { return spool_records; }
+
+uint16_t HttpSpoolClass::getPendingBytes(void) { return spool_ring_used; }
+
+uint32_t HttpSpoolClass::getDroppedRecords(void) { return dropped_records; }
+
+uint16_t HttpSpoolClass::getLastStatusCode(void) { return last_status_code; }
@@ -0,0 +1,161 @@
+/**
+ * @brief Batching of small uploads, e.g. sensor samples, built on HttpClient.
+ * Records are appended to a ring in RAM and sent together in one POST when
+ * enough of them have been collected, when the oldest of them has waited long
+ * enough, or before the device goes to sleep with LowPowerClass::powerSave().
+ * The records are only removed from the ring when the server has answered the
+ * POST with a 2xx status code, so they are kept and sent again with the next
+ * flush if the upload fails.
+ */
+
+#ifndef HTTP_SPOOL_H
+#define HTTP_SPOOL_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of the RAM ring holding the records waiting to be sent. Every
+ * record occupies its length plus one byte for the newline or two bytes for
+ * the length prefix.
+ */
+#define HTTP_SPOOL_SIZE (512)
+
+/**
+ * @brief Default amount of spooled bytes which makes the spool due for a flush.
+ */
+#define HTTP_SPOOL_FLUSH_SIZE (384)
+
+/**
+ * @brief Default time the oldest record can wait before the spool is due for a
+ * flush.
+ */
+#define HTTP_SPOOL_MAX_AGE_MS (300000UL)
+
+/**
+ * @brief Maximum length of the endpoint the records are posted to (including
+ * NULL termination).
+ */
+#define HTTP_SPOOL_ENDPOINT_LENGTH (64)
+
+enum class HttpSpoolFormat {
+    // Every record is followed by a newline, and the body is posted as plain
+    // text. Records can't contain newlines.
+    NEWLINE_DELIMITED = 0,
+
+    // Every record is preceded by its length as two bytes in big endian, and
+    // the body is posted as an octet stream.
+    LENGTH_PREFIXED
+};
+
+class HttpSpoolClass {
+
+  private:
+    HttpSpoolClass(){};
+
+  public:
+    static HttpSpoolClass& instance(void) {
+        static HttpSpoolClass instance;
+        return instance;
+    }
+
+    /**
+     * @brief Sets up the spool, any records already spooled are discarded.
+     * The records are posted to the host configured in HttpClient. The spool
+     * is also flushed by LowPower.powerSave() before the modem goes to sleep,
+     * which can delay the sleep by up to the timeout of the request.
+     *
+     * @param endpoint The part of the URL after the host name the records are
+     * posted to.
+     * @param format How the records are separated in the body.
+     * @param flush_size Amount of spooled bytes at which the spool is due for
+     * a flush.
+     * @param max_age_ms Time the oldest record can wait before the spool is due
+     * for a flush. 0 disables the age threshold.
+     *
+     * @return false if the endpoint is too long.
+     */
+    bool
+    begin(const char* endpoint,
+          const HttpSpoolFormat format = HttpSpoolFormat::NEWLINE_DELIMITED,
+          const uint16_t flush_size    = HTTP_SPOOL_FLUSH_SIZE,
+          const uint32_t max_age_ms    = HTTP_SPOOL_MAX_AGE_MS);
+
+    /**
+     * @brief Discards the spooled records and stops flushing before power
+     * save.
+     */
+    void end(void);
+
+    /**
+     * @brief Appends a record to the spool. If there is not enough space, the
+     * oldest records are dropped to make room for it. Does not send anything,
+     * see #poll() and #flush().
+     *
+     * @return false if the spool is not set up, the record doesn't fit in the
+     * spool or it contains a newline with HttpSpoolFormat::NEWLINE_DELIMITED.
+     */
+    bool append(const uint8_t* record, const uint16_t length);
+
+    bool append(const char* record);
+
+    /**
+     * @return true if the size or age threshold given in #begin() has been
+     * reached.
+     */
+    bool isFlushDue(void);
+
+    /**
+     * @brief Flushes the spool if it is due, see #isFlushDue(). Meant to be
+     * called regularly from the application's loop. Will block whilst
+     * flushing.
+     *
+     * If deferring on weak signal is enabled, a due flush is postponed until
+     * LteSignalClass::isGoodTimeToTransmit(), unless the spool is three
+     * quarters full or the oldest record has waited twice the maximum age.
+     *
+     * @return false if a flush was due and failed.
+     */
+    bool poll(void);
+
+    /**
+     * @brief Enables deferring the flushes done by #poll() whilst the signal
+     * is weak. The signal is sampled with LteSignalClass::poll() when a flush
+     * is due.
+     */
+    void deferOnWeakSignal(const bool enable = true);
+
+    /**
+     * @brief Posts all the spooled records in one request. The records are
+     * removed from the spool if the server responds with a 2xx status code,
+     * otherwise they are kept for the next attempt. Will block until done.
+     *
+     * @return true if the records were acknowledged or the spool is empty.
+     */
+    bool flush(void);
+
+    /**
+     * @return The number of records waiting to be sent.
+     */
+    uint16_t getPendingRecords(void);
+
+    /**
+     * @return The number of bytes waiting to be sent, including separators.
+     */
+    uint16_t getPendingBytes(void);
+
+    /**
+     * @return The number of records dropped to make room for new ones since
+     * #begin().
+     */
+    uint32_t getDroppedRecords(void);
+
+    /**
+     * @return The status code of the last flush, or 0 if the request failed.
+     */
+    uint16_t getLastStatusCode(void);
+};
+
+extern HttpSpoolClass HttpSpool;
+
+#endif
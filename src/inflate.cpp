@@ -0,0 +1,587 @@
+#include "inflate.h"
+#include "crc32.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+
+#define INFLATE_MAX_CODE_LENGTH          (15)
+#define INFLATE_NUM_LITERAL_LENGTH_CODES (288)
+#define INFLATE_NUM_DISTANCE_CODES       (30)
+#define INFLATE_NUM_CODE_LENGTH_CODES    (19)
+#define INFLATE_END_OF_BLOCK             (256)
+
+#define GZIP_MAGIC_0 (0x1F)
+#define GZIP_MAGIC_1 (0x8B)
+
+#define GZIP_FLAG_HEADER_CRC (0x02)
+#define GZIP_FLAG_EXTRA      (0x04)
+#define GZIP_FLAG_NAME       (0x08)
+#define GZIP_FLAG_COMMENT    (0x10)
+
+#define ZLIB_FLAG_DICTIONARY (0x20)
+
+#define DEFLATE_METHOD (8)
+
+// The largest amount of bytes which can be summed before the Adler-32 sums
+// have to be reduced to not overflow
+#define ADLER32_BASE     (65521UL)
+#define ADLER32_MAX_SPAN (5552)
+
+const uint16_t LENGTH_BASES[] PROGMEM = {
+    3,   4,   5,   6,   7,   8,   9,   10,  11, 13,
+    15,  17,  19,  23,  27,  31,  35,  43,  51, 59,
+    67,  83,  99,  115, 131, 163, 195, 227, 258};
+
+const uint8_t LENGTH_EXTRA_BITS[] PROGMEM = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                             1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                             4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+const uint16_t DISTANCE_BASES[] PROGMEM = {
+    1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+    33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+const uint8_t DISTANCE_EXTRA_BITS[] PROGMEM = {0, 0, 0, 0, 1,  1,  2,  2,
+                                               3, 3, 4, 4, 5,  5,  6,  6,
+                                               7, 7, 8, 8, 9,  9,  10, 10,
+                                               11, 11, 12, 12, 13, 13};
+
+const uint8_t CODE_LENGTH_ORDER[] PROGMEM = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/**
+ * @brief Builds the canonical Huffman table for the code lengths given.
+ *
+ * @return false if the code lengths are over-subscribed. Incomplete codes are
+ * allowed, decoding the missing codes fails instead.
+ */
+static bool buildHuffmanTable(InflateHuffmanTable* table,
+                              uint16_t* symbols,
+                              const uint8_t* lengths,
+                              const uint16_t num_symbols) {
+
+    memset(table->counts, 0, sizeof(table->counts));
+
+    for (uint16_t i = 0; i < num_symbols; i++) {
+        table->counts[lengths[i]]++;
+    }
+
+    table->counts[0] = 0;
+
+    int32_t left = 1;
+
+    for (uint8_t length = 1; length <= INFLATE_MAX_CODE_LENGTH; length++) {
+        left = (left << 1) - table->counts[length];
+
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    uint16_t offsets[INFLATE_MAX_CODE_LENGTH + 1];
+    offsets[1] = 0;
+
+    for (uint8_t length = 1; length < INFLATE_MAX_CODE_LENGTH; length++) {
+        offsets[length + 1] = offsets[length] + table->counts[length];
+    }
+
+    for (uint16_t i = 0; i < num_symbols; i++) {
+        if (lengths[i] != 0) {
+            symbols[offsets[lengths[i]]++] = i;
+        }
+    }
+
+    table->symbols = symbols;
+
+    return true;
+}
+
+static uint32_t updateAdler32(const uint32_t adler,
+                              const uint8_t* data,
+                              uint16_t length) {
+
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (length > 0) {
+        const uint16_t span = length < ADLER32_MAX_SPAN ? length
+                                                        : ADLER32_MAX_SPAN;
+
+        for (uint16_t i = 0; i < span; i++) {
+            a += *data++;
+            b += a;
+        }
+
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+        length -= span;
+    }
+
+    return (b << 16) | a;
+}
+
+Inflater::Inflater(uint8_t* window_buffer, const uint8_t bits)
+    : window(window_buffer), window_bits(bits) {
+    window_mask = (uint16_t)((1UL << bits) - 1);
+}
+
+uint32_t Inflater::getOutputLength(void) const { return output_length; }
+
+uint16_t Inflater::readBits(const uint8_t count) {
+
+    while (bit_count < count) {
+        const int16_t byte = reader();
+
+        // Zeros are shifted in at the end of the input, the callers check
+        // input_ended before acting on the data
+        if (byte < 0) {
+            input_ended = true;
+        } else {
+            bit_buffer |= (uint32_t)byte << bit_count;
+        }
+
+        bit_count += 8;
+    }
+
+    const uint16_t bits = bit_buffer & ((1UL << count) - 1);
+
+    bit_buffer >>= count;
+    bit_count -= count;
+
+    return bits;
+}
+
+int16_t Inflater::decodeSymbol(const InflateHuffmanTable* table) {
+
+    // Canonical codes of the same length are consecutive, so the code can be
+    // decoded bit by bit only knowing how many codes there are of each length
+    uint16_t code  = 0;
+    uint16_t first = 0;
+    uint16_t index = 0;
+
+    for (uint8_t length = 1; length <= INFLATE_MAX_CODE_LENGTH; length++) {
+        code |= readBits(1);
+
+        const uint16_t count = table->counts[length];
+
+        if (code < first + count) {
+            return table->symbols[index + (code - first)];
+        }
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+void Inflater::writeByte(const uint8_t byte) {
+    window[window_position] = byte;
+    window_position         = (window_position + 1) & window_mask;
+
+    if (window_position == 0) {
+        flush(window_mask + 1);
+    }
+}
+
+void Inflater::flush(const uint16_t length) {
+
+    if (is_gzip) {
+        checksum = crc32Update(checksum, window, length);
+    } else {
+        checksum = updateAdler32(checksum, window, length);
+    }
+
+    sink(window, length, output_length);
+    output_length += length;
+}
+
+InflateResult Inflater::readHeader(const uint8_t first_byte,
+                                   const uint8_t second_byte) {
+
+    if (is_gzip) {
+        if (readBits(8) != DEFLATE_METHOD) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        const uint8_t flags = readBits(8);
+
+        // Modification time, extra flags and operating system
+        for (uint8_t i = 0; i < 6; i++) {
+            readBits(8);
+        }
+
+        if (flags & GZIP_FLAG_EXTRA) {
+            const uint16_t extra_length = readBits(16);
+
+            for (uint16_t i = 0; i < extra_length && !input_ended; i++) {
+                readBits(8);
+            }
+        }
+
+        if (flags & GZIP_FLAG_NAME) {
+            while (readBits(8) != 0 && !input_ended) {}
+        }
+
+        if (flags & GZIP_FLAG_COMMENT) {
+            while (readBits(8) != 0 && !input_ended) {}
+        }
+
+        if (flags & GZIP_FLAG_HEADER_CRC) {
+            readBits(16);
+        }
+
+        checksum = CRC32_INITIAL_VALUE;
+    } else {
+        if (second_byte & ZLIB_FLAG_DICTIONARY) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        // The compressor states the window it used
+        if ((first_byte >> 4) + 8 > window_bits) {
+            return InflateResult::WINDOW_TOO_SMALL;
+        }
+
+        checksum = 1;
+    }
+
+    return input_ended ? InflateResult::TRUNCATED : InflateResult::OK;
+}
+
+InflateResult Inflater::readTrailer(void) {
+
+    // The trailer starts at the next byte boundary
+    readBits(bit_count & 7);
+
+    uint32_t expected_checksum = 0;
+
+    if (is_gzip) {
+        expected_checksum = readBits(16);
+        expected_checksum |= (uint32_t)readBits(16) << 16;
+
+        uint32_t expected_length = readBits(16);
+        expected_length |= (uint32_t)readBits(16) << 16;
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+
+        if (expected_length != output_length) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        checksum = ~checksum;
+    } else {
+        for (uint8_t i = 0; i < 4; i++) {
+            expected_checksum = (expected_checksum << 8) | readBits(8);
+        }
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+    }
+
+    return expected_checksum == checksum ? InflateResult::OK
+                                         : InflateResult::CHECKSUM_MISMATCH;
+}
+
+InflateResult Inflater::inflateStoredBlock(void) {
+
+    readBits(bit_count & 7);
+
+    const uint16_t length            = readBits(16);
+    const uint16_t length_complement = readBits(16);
+
+    if (input_ended) {
+        return InflateResult::TRUNCATED;
+    }
+
+    if (length != (uint16_t)~length_complement) {
+        return InflateResult::INVALID_DATA;
+    }
+
+    for (uint16_t i = 0; i < length; i++) {
+        writeByte(readBits(8));
+    }
+
+    return input_ended ? InflateResult::TRUNCATED : InflateResult::OK;
+}
+
+InflateResult
+Inflater::inflateCompressedBlock(const InflateHuffmanTable* literals,
+                                 const InflateHuffmanTable* distances) {
+
+    while (true) {
+        int16_t symbol = decodeSymbol(literals);
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+
+        if (symbol < 0) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        if (symbol < INFLATE_END_OF_BLOCK) {
+            writeByte(symbol);
+            continue;
+        }
+
+        if (symbol == INFLATE_END_OF_BLOCK) {
+            return InflateResult::OK;
+        }
+
+        symbol -= INFLATE_END_OF_BLOCK + 1;
+
+        if (symbol >= (int16_t)sizeof(LENGTH_EXTRA_BITS)) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        uint16_t length = pgm_read_word(&LENGTH_BASES[symbol]) +
+                          readBits(pgm_read_byte(&LENGTH_EXTRA_BITS[symbol]));
+
+        symbol = decodeSymbol(distances);
+
+        if (symbol < 0 || symbol >= INFLATE_NUM_DISTANCE_CODES) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        const uint16_t distance =
+            pgm_read_word(&DISTANCE_BASES[symbol]) +
+            readBits(pgm_read_byte(&DISTANCE_EXTRA_BITS[symbol]));
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+
+        if (distance > (uint32_t)window_mask + 1) {
+            return InflateResult::WINDOW_TOO_SMALL;
+        }
+
+        if (distance > output_length + window_position) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        while (length-- > 0) {
+            writeByte(window[(window_position - distance) & window_mask]);
+        }
+    }
+}
+
+InflateResult Inflater::readDynamicTables(InflateHuffmanTable* literals,
+                                          InflateHuffmanTable* distances) {
+
+    const uint16_t num_literals  = readBits(5) + 257;
+    const uint8_t num_distances  = readBits(5) + 1;
+    const uint8_t num_code_sizes = readBits(4) + 4;
+
+    if (num_literals > INFLATE_NUM_LITERAL_LENGTH_CODES ||
+        num_distances > INFLATE_NUM_DISTANCE_CODES) {
+        return InflateResult::INVALID_DATA;
+    }
+
+    uint8_t lengths[INFLATE_NUM_LITERAL_LENGTH_CODES +
+                    INFLATE_NUM_DISTANCE_CODES];
+
+    memset(lengths, 0, INFLATE_NUM_CODE_LENGTH_CODES);
+
+    for (uint8_t i = 0; i < num_code_sizes; i++) {
+        lengths[pgm_read_byte(&CODE_LENGTH_ORDER[i])] = readBits(3);
+    }
+
+    InflateHuffmanTable code_lengths;
+    uint16_t code_length_symbols[INFLATE_NUM_CODE_LENGTH_CODES];
+
+    if (!buildHuffmanTable(&code_lengths,
+                           code_length_symbols,
+                           lengths,
+                           INFLATE_NUM_CODE_LENGTH_CODES)) {
+        return InflateResult::INVALID_DATA;
+    }
+
+    const uint16_t total = num_literals + num_distances;
+    uint16_t index       = 0;
+
+    while (index < total) {
+        const int16_t symbol = decodeSymbol(&code_lengths);
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+
+        if (symbol < 0) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+
+        uint8_t length  = 0;
+        uint8_t repeats = 0;
+
+        if (symbol == 16) {
+            if (index == 0) {
+                return InflateResult::INVALID_DATA;
+            }
+
+            length  = lengths[index - 1];
+            repeats = 3 + readBits(2);
+        } else if (symbol == 17) {
+            repeats = 3 + readBits(3);
+        } else {
+            repeats = 11 + readBits(7);
+        }
+
+        if (index + repeats > total) {
+            return InflateResult::INVALID_DATA;
+        }
+
+        memset(&lengths[index], length, repeats);
+        index += repeats;
+    }
+
+    // A block without the end of block code can't be terminated
+    if (lengths[INFLATE_END_OF_BLOCK] == 0) {
+        return InflateResult::INVALID_DATA;
+    }
+
+    if (!buildHuffmanTable(literals,
+                           literals->symbols,
+                           lengths,
+                           num_literals) ||
+        !buildHuffmanTable(distances,
+                           distances->symbols,
+                           &lengths[num_literals],
+                           num_distances)) {
+        return InflateResult::INVALID_DATA;
+    }
+
+    return InflateResult::OK;
+}
+
+InflateResult Inflater::inflate(InflateReader byte_reader,
+                                InflateSink byte_sink) {
+
+    if (window_bits < INFLATE_MIN_WINDOW_BITS ||
+        window_bits > INFLATE_MAX_WINDOW_BITS || window == nullptr) {
+        return InflateResult::INVALID_ARGUMENT;
+    }
+
+    reader          = byte_reader;
+    sink            = byte_sink;
+    input_ended     = false;
+    bit_buffer      = 0;
+    bit_count       = 0;
+    window_position = 0;
+    output_length   = 0;
+
+    const int16_t first_byte = reader();
+
+    if (first_byte < 0) {
+        return InflateResult::TRUNCATED;
+    }
+
+    const int16_t second_byte = reader();
+
+    is_gzip = first_byte == GZIP_MAGIC_0 && second_byte == GZIP_MAGIC_1;
+
+    const bool is_zlib = (first_byte & 0x0F) == DEFLATE_METHOD &&
+                         second_byte >= 0 &&
+                         (((uint16_t)first_byte << 8) | second_byte) % 31 == 0;
+
+    // Neither gzip nor zlib, so the data is passed through unchanged
+    if (!is_gzip && !is_zlib) {
+        checksum = 1;
+        writeByte(first_byte);
+
+        for (int16_t byte = second_byte; byte >= 0; byte = reader()) {
+            writeByte(byte);
+        }
+
+        if (window_position != 0) {
+            flush(window_position);
+        }
+
+        return InflateResult::OK;
+    }
+
+    InflateResult result = readHeader(first_byte, second_byte);
+
+    if (result != InflateResult::OK) {
+        return result;
+    }
+
+    uint16_t literal_symbols[INFLATE_NUM_LITERAL_LENGTH_CODES];
+    uint16_t distance_symbols[INFLATE_NUM_DISTANCE_CODES];
+
+    InflateHuffmanTable literals  = {{0}, literal_symbols};
+    InflateHuffmanTable distances = {{0}, distance_symbols};
+
+    bool final_block = false;
+
+    while (!final_block) {
+        final_block        = readBits(1);
+        const uint8_t type = readBits(2);
+
+        if (input_ended) {
+            return InflateResult::TRUNCATED;
+        }
+
+        switch (type) {
+        case 0:
+            result = inflateStoredBlock();
+            break;
+
+        case 1: {
+            // The fixed codes are built into the tables of the dynamic codes
+            // as they are not used at the same time
+            uint8_t lengths[INFLATE_NUM_LITERAL_LENGTH_CODES];
+
+            memset(&lengths[0], 8, 144);
+            memset(&lengths[144], 9, 112);
+            memset(&lengths[256], 7, 24);
+            memset(&lengths[280], 8, 8);
+
+            buildHuffmanTable(&literals,
+                              literal_symbols,
+                              lengths,
+                              INFLATE_NUM_LITERAL_LENGTH_CODES);
+
+            memset(lengths, 5, INFLATE_NUM_DISTANCE_CODES);
+
+            buildHuffmanTable(&distances,
+                              distance_symbols,
+                              lengths,
+                              INFLATE_NUM_DISTANCE_CODES);
+
+            result = inflateCompressedBlock(&literals, &distances);
+            break;
+        }
+
+        case 2:
+            result = readDynamicTables(&literals, &distances);
+
+            if (result == InflateResult::OK) {
+                result = inflateCompressedBlock(&literals, &distances);
+            }
+            break;
+
+        default:
+            result = InflateResult::INVALID_DATA;
+            break;
+        }
+
+        if (result != InflateResult::OK) {
+            return result;
+        }
+    }
+
+    if (window_position != 0) {
+        flush(window_position);
+    }
+
+    return readTrailer();
+}
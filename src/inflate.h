@@ -0,0 +1,113 @@
+/**
+ * @brief Streaming decoder for deflate compressed data (RFC 1951) in the gzip
+ * (RFC 1952) or zlib (RFC 1950) format, as used for compressed HTTP bodies.
+ */
+
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Range of the window size, given as the base-two logarithm of the
+ * amount of bytes. The data has to be compressed with a window no larger than
+ * the window of the decoder, e.g. with zlib's windowBits.
+ */
+#define INFLATE_MIN_WINDOW_BITS (8)
+#define INFLATE_MAX_WINDOW_BITS (15)
+
+enum class InflateResult {
+    OK = 0,
+    TRUNCATED,
+    INVALID_DATA,
+    WINDOW_TOO_SMALL,
+    CHECKSUM_MISMATCH,
+    INVALID_ARGUMENT
+};
+
+/**
+ * @brief Supplies the compressed data one byte at a time.
+ *
+ * @return The next byte or -1 when there is no more data.
+ */
+typedef int16_t (*InflateReader)(void);
+
+/**
+ * @brief Receives the decompressed data. Called every time the window is full
+ * and at the end of the data.
+ *
+ * @param data The decompressed data.
+ * @param length Amount of bytes in @p data.
+ * @param offset Offset of @p data within the decompressed data.
+ */
+typedef void (*InflateSink)(const uint8_t* data,
+                            const uint16_t length,
+                            const uint32_t offset);
+
+typedef struct {
+    uint16_t counts[16];
+    uint16_t* symbols;
+} InflateHuffmanTable;
+
+class Inflater {
+
+  private:
+    uint8_t* window;
+    uint8_t window_bits;
+    uint16_t window_mask;
+    uint16_t window_position;
+    uint32_t output_length;
+
+    InflateReader reader;
+    InflateSink sink;
+    bool input_ended;
+
+    uint32_t bit_buffer;
+    uint8_t bit_count;
+
+    bool is_gzip;
+    uint32_t checksum;
+
+    uint16_t readBits(const uint8_t count);
+    int16_t decodeSymbol(const InflateHuffmanTable* table);
+
+    void writeByte(const uint8_t byte);
+    void flush(const uint16_t length);
+
+    InflateResult readHeader(const uint8_t first_byte,
+                             const uint8_t second_byte);
+    InflateResult readTrailer(void);
+    InflateResult inflateStoredBlock(void);
+    InflateResult inflateCompressedBlock(const InflateHuffmanTable* literals,
+                                         const InflateHuffmanTable* distances);
+    InflateResult readDynamicTables(InflateHuffmanTable* literals,
+                                    InflateHuffmanTable* distances);
+
+  public:
+    /**
+     * @param window Buffer of 2^ @p window_bits bytes used for the back
+     * references. The decompressed data is delivered to the sink from here.
+     * @param window_bits Base-two logarithm of the window size, between
+     * #INFLATE_MIN_WINDOW_BITS and #INFLATE_MAX_WINDOW_BITS.
+     */
+    Inflater(uint8_t* window, const uint8_t window_bits);
+
+    /**
+     * @brief Decompresses gzip or zlib data from @p reader into @p sink. Data
+     * in neither format is passed through unchanged, so that a server which
+     * ignores the requested content encoding is handled as well. Uses about 1
+     * kB of stack on top of the window.
+     *
+     * @return InflateResult::OK when the whole stream was decompressed and the
+     * checksum matched, or InflateResult::WINDOW_TOO_SMALL if the data refers
+     * further back than the window.
+     */
+    InflateResult inflate(InflateReader reader, InflateSink sink);
+
+    /**
+     * @return Amount of decompressed bytes delivered to the sink.
+     */
+    uint32_t getOutputLength(void) const;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "led_ctrl.h"
 #include "log.h"
 #include "lte.h"
+#include "network_time.h"
 #include "sequans_controller.h"
 #include "timeout_timer.h"
 
@@ -75,6 +76,15 @@ static uint32_t period = 0;
  */
 static uint32_t period_requested = 0;
 
+/**
+ * @brief Whether the last attempt at retrieving the period from the operator
+ * for getPowerSaveModePeriod() failed, and when it was made.
+ */
+static bool period_retrieval_failed       = false;
+static uint32_t period_retrieval_failed_ms = 0;
+
+static void (*pre_sleep_callbacks[LOW_POWER_MAX_PRE_SLEEP_CALLBACKS])(void);
+
 /**
  * @brief Contains stored values of the PINCTRL register for the respective
  * ports.
@@ -667,7 +677,8 @@ void LowPowerClass::configurePeriodicPowerSave(
 
     // Reset in case there is a reconfiguration after sleep has been called
     // previously
-    retrieved_period = false;
+    retrieved_period        = false;
+    period_retrieval_failed = false;
 
     // We need sequans controller to be initialized first before configuration
     if (!SequansController.isInitialized()) {
@@ -715,7 +726,14 @@ void LowPowerClass::configurePeriodicPowerSave(
                                    PSM_DEFAULT_PAGING_PARAMETER);
 }
 
-void LowPowerClass::powerSave(void) {
+/**
+ * @brief Retrieves the period the operator gave for PSM if it has not been
+ * retrieved already.
+ *
+ * @return The period in seconds, or 0 if the operator did not give a valid
+ * period.
+ */
+static uint32_t retrievePeriod(void) {
 
     if (!retrieved_period) {
         // Retrieve the proper sleep time set by the operator, which may
@@ -724,7 +742,7 @@ void LowPowerClass::powerSave(void) {
 
         if (period == 0) {
             Log.warnf(F("Got invalid period from operator: %d\r\n"), period);
-            return;
+            return 0;
         } else {
             if (period_requested != period) {
                 Log.warnf(
@@ -739,6 +757,44 @@ void LowPowerClass::powerSave(void) {
         }
     }
 
+    return period;
+}
+
+uint32_t LowPowerClass::getPowerSaveModePeriod(void) {
+
+    // Power save mode has not been configured, so there is no period to get
+    if (period_requested == 0) {
+        return 0;
+    }
+
+    // Don't query the modem and log a warning on every call whilst the
+    // operator doesn't give a period
+    if (!retrieved_period && period_retrieval_failed &&
+        millis() - period_retrieval_failed_ms <
+            LOW_POWER_PERIOD_RETRY_INTERVAL_MS) {
+        return 0;
+    }
+
+    const uint32_t retrieved = retrievePeriod();
+
+    period_retrieval_failed    = (retrieved == 0);
+    period_retrieval_failed_ms = millis();
+
+    return retrieved;
+}
+
+void LowPowerClass::powerSave(void) {
+
+    if (retrievePeriod() == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < LOW_POWER_MAX_PRE_SLEEP_CALLBACKS; i++) {
+        if (pre_sleep_callbacks[i] != NULL) {
+            pre_sleep_callbacks[i]();
+        }
+    }
+
     if (!attemptToEnterPowerSaveModeForModem(45000)) {
         Log.error(
             F("Failed to put cellular modem in sleep. Power save functionality "
@@ -768,11 +824,47 @@ void LowPowerClass::powerSave(void) {
         powerUpPeripherals();
 
         modem_is_in_power_save = false;
+
+        // There is no telling how long we slept, so the time has to be read
+        // from the modem again
+        NetworkTime.invalidate();
     }
 
     SequansController.setPowerSaveMode(0, NULL);
 }
 
+bool LowPowerClass::registerPreSleepCallback(void (*callback)(void)) {
+
+    int8_t free_index = -1;
+
+    for (uint8_t i = 0; i < LOW_POWER_MAX_PRE_SLEEP_CALLBACKS; i++) {
+        if (pre_sleep_callbacks[i] == callback) {
+            return true;
+        }
+
+        if (pre_sleep_callbacks[i] == NULL && free_index < 0) {
+            free_index = i;
+        }
+    }
+
+    if (free_index < 0) {
+        return false;
+    }
+
+    pre_sleep_callbacks[free_index] = callback;
+
+    return true;
+}
+
+void LowPowerClass::unregisterPreSleepCallback(void (*callback)(void)) {
+
+    for (uint8_t i = 0; i < LOW_POWER_MAX_PRE_SLEEP_CALLBACKS; i++) {
+        if (pre_sleep_callbacks[i] == callback) {
+            pre_sleep_callbacks[i] = NULL;
+        }
+    }
+}
+
 void LowPowerClass::powerDown(const uint32_t power_down_time_seconds) {
 
     SLPCTRL.CTRLA |= SLPCTRL_SMODE_PDOWN_gc | SLPCTRL_SEN_bm;
@@ -804,6 +896,10 @@ void LowPowerClass::powerDown(const uint32_t power_down_time_seconds) {
 
     restart_millis();
 
+    // The PIT kept track of the time whilst millis() was stopped
+    NetworkTime.addElapsedTime(
+        (power_down_time_seconds - remaining_time_seconds) * 1000UL);
+
     disableLDO();
     disablePIT();
     SLPCTRL.CTRLA &= ~SLPCTRL_SEN_bm;
@@ -3,6 +3,18 @@
 
 #include <stdint.h>
 
+/**
+ * @brief Amount of callbacks which can be registered with
+ * LowPowerClass::registerPreSleepCallback().
+ */
+#define LOW_POWER_MAX_PRE_SLEEP_CALLBACKS (4)
+
+/**
+ * @brief How long LowPowerClass::getPowerSaveModePeriod() waits before asking
+ * the operator for the period again after a failed attempt.
+ */
+#define LOW_POWER_PERIOD_RETRY_INTERVAL_MS (60000UL)
+
 /**
  * @brief Multipliers for cellular network power save mode when the cellular
  * modem is periodically sleeping.
@@ -65,6 +77,19 @@ class LowPowerClass {
         const PowerSaveModePeriodMultiplier power_save_mode_period_multiplier,
         const uint8_t power_save_mode_period_value);
 
+    /**
+     * @brief Retrieves the power save mode period granted by the operator
+     * after #configurePeriodicPowerSave(). The period is retrieved from the
+     * modem the first time and cached until power save is configured again.
+     * If the operator does not give a period, the modem is not asked again
+     * for #LOW_POWER_PERIOD_RETRY_INTERVAL_MS, so that this can be called
+     * frequently.
+     *
+     * @return The period in seconds, 0 if power save mode is not configured or
+     * the period could not be retrieved.
+     */
+    uint32_t getPowerSaveModePeriod(void);
+
     /**
      * @brief Will attempt to put the modem in power save and then power down
      * the MCU for the time configured in configurePeriodicPowerSave(). Note
@@ -75,6 +100,18 @@ class LowPowerClass {
      */
     void powerSave(void);
 
+    /**
+     * @brief Registers @p callback to be called by #powerSave() whilst the
+     * modem is still awake, before it is put in power save. Used for work
+     * which should not wait for a whole power save period, such as sending
+     * buffered data. Registering a callback twice has no effect.
+     *
+     * @return false if there is no room for more callbacks.
+     */
+    bool registerPreSleepCallback(void (*callback)(void));
+
+    void unregisterPreSleepCallback(void (*callback)(void));
+
     /**
      * @brief Will power down both CPU and cellular modem. All active
      * connections on the modem will be terminated.
@@ -1,13 +1,22 @@
 #include "lte.h"
 
+#include "crc32.h"
 #include "flash_string.h"
+#include "http_client.h"
 #include "led_ctrl.h"
 #include "log.h"
 #include "mqtt_client.h"
+#include "network_time.h"
 #include "sequans_controller.h"
 #include "timeout_timer.h"
 
 #include <Arduino.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <util/delay.h>
 
 #define TIMEZONE_WAIT_MS 10000
@@ -23,10 +32,67 @@
 // index.
 #define CEREG_STAT_CHARACTER_INDEX 1
 
+// The cell ID is the third value of the CEREG URC with CEREG=5
+#define CEREG_CELL_ID_INDEX 2
+
+// Interval the CELL LED is toggled with whilst connecting
+#define LED_TOGGLE_INTERVAL_MS 500
+
+// Fits the bands supported by the modem as a comma separated list
+#define BAND_LIST_LENGTH 64
+
+// Time to wait for every line of a response read by readResponseLine()
+#define READ_LINE_TIMEOUT_MS 2000
+
 const char AT_DISCONNECT[] PROGMEM     = "AT+CFUN=0";
 const char CEREG_CALLBACK[] PROGMEM    = "CEREG";
 const char TIMEZONE_CALLBACK[] PROGMEM = "CTZV";
 
+// Start of the line with the bands of the standard profile for LTE-M in the
+// response to AT+SQNBANDSEL?
+const char BAND_SELECTION_PREFIX[] PROGMEM = "+SQNBANDSEL: 0,\"standard\",\"";
+const char NTP_CALLBACK[] PROGMEM      = "SQNNTP";
+
+/**
+ * @brief Downlink EARFCN ranges of the LTE-M bands supported by the modem, see
+ * 3GPP TS 36.101.
+ */
+typedef struct {
+    uint8_t band;
+    uint32_t first_earfcn;
+    uint32_t last_earfcn;
+} BandEarfcnRange;
+
+const BandEarfcnRange BAND_EARFCN_RANGES[] PROGMEM = {
+    {1, 0, 599},        {2, 600, 1199},     {3, 1200, 1949},
+    {4, 1950, 2399},    {5, 2400, 2649},    {8, 3450, 3799},
+    {12, 5010, 5179},   {13, 5180, 5279},   {14, 5280, 5379},
+    {17, 5730, 5849},   {18, 5850, 5999},   {19, 6000, 6149},
+    {20, 6150, 6449},   {25, 8040, 8689},   {26, 8690, 9039},
+    {28, 9210, 9659},   {66, 66436, 67335}, {71, 68586, 68935},
+    {85, 70366, 70545}};
+
+#define NUM_BANDS (sizeof(BAND_EARFCN_RANGES) / sizeof(BAND_EARFCN_RANGES[0]))
+
+/**
+ * @brief The last known cell, laid out as it is persisted in EEPROM.
+ */
+typedef struct {
+    // The band is 0 if no cell is cached
+    LteCellInfo cell;
+
+    // The band selection of the modem from before it was restricted to the
+    // band of the cell, which the modem persists. Empty if not restricted
+    char original_bands[BAND_LIST_LENGTH];
+
+    // Guards against a record which was only partially written or is not
+    // written at all
+    uint32_t record_crc32;
+} CellCacheRecord;
+
+static_assert(sizeof(CellCacheRecord) <= EEPROM_LAYOUT_LTE_CELL_CACHE_SIZE,
+              "The cell cache record doesn't fit in its space in EEPROM");
+
 /**
  * @brief Singleton. Defined for use of the rest of the library.
  */
@@ -47,19 +113,130 @@ static volatile bool is_connected = false;
  */
 static volatile bool got_timezone = false;
 
+/**
+ * @brief The SIM card status is only checked the first time, as it won't change
+ * unless the SIM card is removed, which in that case will show as a failed
+ * registration.
+ */
+static bool sim_is_ready = false;
+
+/**
+ * @brief Whether the time of the modem has been checked to be valid. Is kept
+ * until the modem is shut down.
+ */
+static bool time_is_valid = false;
+
+/**
+ * @brief Time the last successful #begin() took, and whether an existing
+ * registration was reused.
+ */
+static uint32_t connect_time_ms = 0;
+static bool connection_resumed  = false;
+
+static LteState state = LteState::OFF;
+
+static void (*state_change_callback)(const LteState state) = NULL;
+
+/**
+ * @brief Set when the first CEREG URC arrives after starting to connect, as the
+ * SIM card can only be checked after that.
+ */
+static volatile bool got_cereg = false;
+
+/**
+ * @brief Cell ID of the serving cell from the last CEREG URC, 0 if not
+ * registered.
+ */
+static volatile uint32_t cell_id = 0;
+
+/**
+ * @brief Status of the last NTP sync from the SQNNTP URC, 0 whilst waiting for
+ * it.
+ */
+static volatile char ntp_status = 0;
+
+/**
+ * @brief The steps of the time synchronization in LteState::TIME_SYNC.
+ */
+enum class TimeSyncStep {
+    CHECK_CLOCK,
+    WAIT_FOR_TIMEZONE,
+    REQUEST_NTP_SYNC,
+    WAIT_FOR_NTP_SYNC
+};
+
+static TimeSyncStep time_sync_step = TimeSyncStep::CHECK_CLOCK;
+
+/**
+ * @brief Whether the network time has been anchored during the current
+ * attach, so that #connected() doesn't read the time from the modem twice.
+ */
+static bool time_anchored = false;
+
+/**
+ * @brief Timeout given to #beginAsync(), which applies to the registration and
+ * the time synchronization separately, and when they started.
+ */
+static uint32_t connect_timeout_ms = 0;
+static uint32_t connect_start_ms   = 0;
+static uint32_t state_start_ms     = 0;
+static uint32_t step_start_ms      = 0;
+static uint32_t led_toggle_ms      = 0;
+
+static bool cell_cache_enabled = false;
+
+/**
+ * @brief Whether the search for the network is restricted to the band of the
+ * last known cell during the current attach, and when the attach started.
+ */
+static bool search_restricted   = false;
+static uint32_t attach_start_ms = 0;
+
+static LteAttachStatistics attach_statistics = {};
+
+/**
+ * @brief Parses the cell ID from the CEREG URC data, which is a hexadecimal
+ * string in quotes.
+ *
+ * @return The cell ID or 0 if it isn't included.
+ */
+static uint32_t parseCellId(const char* buffer) {
+
+    for (uint8_t commas = 0; commas < CEREG_CELL_ID_INDEX; buffer++) {
+        if (*buffer == '\0') {
+            return 0;
+        }
+
+        if (*buffer == ',') {
+            commas++;
+        }
+    }
+
+    if (*buffer == '"') {
+        buffer++;
+    }
+
+    return strtoul(buffer, NULL, 16);
+}
+
 static void connectionStatus(char* buffer) {
 
     const char stat = buffer[CEREG_STAT_CHARACTER_INDEX];
 
+    got_cereg = true;
+
     if (stat == STAT_REGISTERED_ROAMING ||
         stat == STAT_REGISTERED_HOME_NETWORK) {
 
         is_connected = true;
+        cell_id      = parseCellId(buffer);
 
         LedCtrl.on(Led::CELL, true);
 
     } else {
 
+        cell_id = 0;
+
         if (is_connected) {
             is_connected = false;
             LedCtrl.off(Led::CELL, true);
@@ -79,55 +256,80 @@ static void timezoneCallback(__attribute__((unused)) char* buffer) {
     got_timezone = true;
 }
 
-bool LteClass::begin(const uint32_t timeout_ms, const bool print_messages) {
+static void ntpCallback(char* buffer) { ntp_status = buffer[NTP_STATUS_INDEX]; }
 
-    const TimeoutTimer timeout_timer(timeout_ms);
+static void setState(const LteState new_state) {
 
-    // If low power is utilized, the modem will already be initialized, so don't
-    // reset it by calling begin again
-    if (!SequansController.isInitialized()) {
-        if (!SequansController.begin()) {
-            return false;
-        }
+    if (new_state == state) {
+        return;
     }
 
-    // Disconnect before configuration if already connected
-    SequansController.writeCommand(FV(AT_DISCONNECT));
-
-    // Enable time zone callback
-    SequansController.registerCallback(FV(TIMEZONE_CALLBACK), timezoneCallback);
+    state          = new_state;
+    state_start_ms = millis();
 
-    // Enable time zone update
-    SequansController.writeCommand(F("AT+CTZU=1"));
+    if (state_change_callback != NULL) {
+        state_change_callback(new_state);
+    }
+}
 
-    // Enable time zone reporting
-    SequansController.writeCommand(F("AT+CTZR=1"));
+/**
+ * @brief Shuts down the modem after a failed attempt to connect.
+ */
+static void fail(void) {
+    setState(LteState::FAILED);
+    Lte.end();
+}
 
-    // Enable CEREG URC
-    SequansController.writeCommand(F("AT+CEREG=5"));
+static bool hasTimedOut(const uint32_t start_ms, const uint32_t timeout_ms) {
+    return millis() - start_ms >= timeout_ms;
+}
 
-    // Start connecting to the operator
-    SequansController.writeCommand(F("AT+CFUN=1"));
+/**
+ * @brief Queries settings of the modem with @p command, e.g. AT+CEREG?, and
+ * places the first character of each of the first @p num_values values of the
+ * response in @p values. A value which could not be retrieved is set to 0.
+ */
+static void querySettings(const __FlashStringHelper* command,
+                          char* values,
+                          const uint8_t num_values) {
 
     char response_buffer[64] = "";
-    char value_buffer[32]    = "";
+    char value_buffer[8]     = "";
 
-    // Wait for initial CEREG URC before checking SIM
-    SequansController.waitForURC(FV(CEREG_CALLBACK));
+    memset(values, 0, num_values);
 
-    SequansController.registerCallback(FV(CEREG_CALLBACK),
-                                       connectionStatus,
-                                       false);
+    if (SequansController.writeCommand(command,
+                                       response_buffer,
+                                       sizeof(response_buffer)) !=
+        ResponseResult::OK) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < num_values; i++) {
+        if (SequansController.extractValueFromCommandResponse(
+                response_buffer,
+                i,
+                value_buffer,
+                sizeof(value_buffer))) {
+            values[i] = value_buffer[0];
+        }
+    }
+}
+
+/**
+ * @brief Checks that the SIM card is inserted and ready. Note that we can only
+ * do this and get a meaningful response in CFUN=1 or CFUN=4.
+ */
+static bool checkSim(void) {
+
+    char response_buffer[64] = "";
+    char value_buffer[32]    = "";
 
-    // We check that the SIM card is inserted and ready. Note that we can only
-    // do this and get a meaningful response in CFUN=1 or CFUN=4.
     if (SequansController.writeCommand(F("AT+CPIN?"),
                                        response_buffer,
                                        sizeof(response_buffer)) !=
         ResponseResult::OK) {
         Log.error(F("Checking SIM card failed, is it inserted?"));
-        Lte.end();
-
         return false;
     }
 
@@ -137,151 +339,682 @@ bool LteClass::begin(const uint32_t timeout_ms, const bool print_messages) {
             value_buffer,
             sizeof(value_buffer))) {
         Log.error(F("Failed to retrieve SIM status."));
-        Lte.end();
-
         return false;
     }
 
     if (strncmp_P(value_buffer, PSTR("READY"), 5) != 0) {
         Log.errorf(F("SIM card is not ready, status: %s."), value_buffer);
-        Lte.end();
+        return false;
+    }
+
+    sim_is_ready = true;
+
+    return true;
+}
+
+/**
+ * @return The band of @p earfcn, or 0 if it is not within one of the bands
+ * supported.
+ */
+static uint8_t bandFromEarfcn(const uint32_t earfcn) {
+
+    for (uint8_t i = 0; i < NUM_BANDS; i++) {
+        BandEarfcnRange range;
+        memcpy_P(&range, &BAND_EARFCN_RANGES[i], sizeof(range));
+
+        if (earfcn >= range.first_earfcn && earfcn <= range.last_earfcn) {
+            return range.band;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t cellCacheRecordCrc32(const CellCacheRecord* record) {
+    return crc32Update(CRC32_INITIAL_VALUE,
+                       (const uint8_t*)record,
+                       offsetof(CellCacheRecord, record_crc32));
+}
 
+/**
+ * @brief Reads the cell cache record from EEPROM. A record which is not valid
+ * reads as empty.
+ */
+static void readCellCacheRecord(CellCacheRecord* record) {
+
+    eeprom_read_block(record,
+                      (const void*)LTE_CELL_CACHE_EEPROM_ADDRESS,
+                      sizeof(CellCacheRecord));
+
+    if (record->record_crc32 != cellCacheRecordCrc32(record)) {
+        memset(record, 0, sizeof(CellCacheRecord));
+    }
+}
+
+static void writeCellCacheRecord(CellCacheRecord* record) {
+
+    record->record_crc32 = cellCacheRecordCrc32(record);
+
+    // Only the bytes which have changed are written, which limits the wear
+    eeprom_update_block(record,
+                        (void*)LTE_CELL_CACHE_EEPROM_ADDRESS,
+                        sizeof(CellCacheRecord));
+}
+
+static bool loadCellCache(LteCellInfo* cell) {
+
+    CellCacheRecord record;
+    readCellCacheRecord(&record);
+
+    if (record.cell.band == 0) {
         return false;
     }
 
-    if (print_messages) {
-        Log.infof(F("Connecting to operator"));
+    *cell = record.cell;
+
+    return true;
+}
+
+/**
+ * @brief Reads a line of a command response from the modem, without the line
+ * ending. A line which doesn't fit in @p line is consumed, but reported as
+ * empty.
+ *
+ * @return false if no complete line was received within #READ_LINE_TIMEOUT_MS.
+ */
+static bool readResponseLine(char* line, const size_t line_size) {
+
+    const TimeoutTimer timeout_timer(READ_LINE_TIMEOUT_MS);
+    size_t length  = 0;
+    bool truncated = false;
+
+    while (!timeout_timer.hasTimedOut()) {
+
+        const int16_t byte = SequansController.readByte();
+
+        if (byte < 0 || byte == '\r') {
+            continue;
+        }
+
+        if (byte == '\n') {
+            if (length == 0 && !truncated) {
+                continue;
+            }
+
+            line[truncated ? 0 : length] = '\0';
+            return true;
+        }
+
+        if (length < line_size - 1) {
+            line[length++] = (char)byte;
+        } else {
+            truncated = true;
+        }
     }
 
-    while (!isConnected() && !timeout_timer.hasTimedOut()) {
-        LedCtrl.toggle(Led::CELL, true);
-        _delay_ms(500);
+    return false;
+}
 
-        if (print_messages) {
-            Log.rawf(F("."));
+/**
+ * @brief Retrieves the bands the modem searches for LTE-M in the standard
+ * operator profile, which is the one #writeBands() sets, as a comma separated
+ * list.
+ */
+static bool queryBands(char* bands, const size_t bands_size) {
+
+    // The response has a line per RAT and operator profile, e.g.
+    // +SQNBANDSEL: 0,"standard","1,2,3,4,5,8,12,13,14,17,18,19,20,25,26,28"
+    // which is too long in total to be buffered, so it is read a line at a
+    // time and only the bands of the standard profile for LTE-M (0) are kept
+    SequansController.clearReceiveBuffer();
+
+    if (!SequansController.writeString(F("AT+SQNBANDSEL?"), true)) {
+        return false;
+    }
+
+    char line[sizeof(BAND_SELECTION_PREFIX) + BAND_LIST_LENGTH + 1];
+    bool found = false;
+
+    while (readResponseLine(line, sizeof(line))) {
+
+        if (strcmp_P(line, PSTR("OK")) == 0) {
+            return found;
+        }
+
+        if (strcmp_P(line, PSTR("ERROR")) == 0) {
+            return false;
+        }
+
+        if (strncmp_P(line,
+                      BAND_SELECTION_PREFIX,
+                      strlen_P(BAND_SELECTION_PREFIX)) != 0) {
+            continue;
+        }
+
+        char* start = &line[strlen_P(BAND_SELECTION_PREFIX)];
+        char* end   = strchr(start, '"');
+
+        if (end == NULL) {
+            continue;
+        }
+
+        *end = '\0';
+
+        const size_t length = end - start;
+
+        if (length > 0 && length < bands_size &&
+            strspn(start, "0123456789,") == length) {
+            strcpy(bands, start);
+            found = true;
         }
     }
 
-    if (!isConnected()) {
-        const char* error_message = PSTR(
-            "Was not able to connect to the network within the timeout "
-            "of %d ms. Consider increasing the timeout or checking your "
-            "cellular coverage.\r\n");
+    return false;
+}
+
+/**
+ * @brief Sets the bands the modem searches. Has to be done in CFUN=0.
+ */
+static bool writeBands(const char* bands) {
+
+    const ResponseResult result = SequansController.writeCommand(
+        F("AT+SQNBANDSEL=0,\"standard\",\"%s\""),
+        NULL,
+        0,
+        bands);
+
+    if (result != ResponseResult::OK) {
+        Log.errorf(F("Failed to select bands %s, error code: %X\r\n"),
+                   bands,
+                   static_cast<uint8_t>(result));
+        return false;
+    }
 
-        if (print_messages) {
-            Log.rawf(F(" ERROR: %S\r\n"), error_message);
-        } else {
-            Log.errorf(F("%S\r\n"), error_message);
+    return true;
+}
+
+/**
+ * @brief Restricts the bands the modem searches to @p band. The band
+ * selection from before is persisted first, so that it can be restored even
+ * if the device resets in the meantime.
+ */
+static bool restrictBands(const uint8_t band) {
+
+    CellCacheRecord record;
+    readCellCacheRecord(&record);
+
+    if (record.original_bands[0] == '\0') {
+        if (!queryBands(record.original_bands,
+                        sizeof(record.original_bands))) {
+            Log.warn(F("Failed to retrieve the band selection of the modem"));
+            return false;
         }
 
-        Lte.end();
+        writeCellCacheRecord(&record);
+    }
+
+    char bands[4] = "";
+    snprintf(bands, sizeof(bands), "%u", band);
+
+    return writeBands(bands);
+}
 
+/**
+ * @brief Restores the band selection from before it was restricted to the
+ * band of the last known cell, if it is restricted. Has to be done in CFUN=0.
+ */
+static bool restoreBands(void) {
+
+    CellCacheRecord record;
+    readCellCacheRecord(&record);
+
+    if (record.original_bands[0] == '\0') {
+        return true;
+    }
+
+    if (!writeBands(record.original_bands)) {
         return false;
     }
 
-    if (print_messages) {
-        Log.rawf(" OK!\r\n");
+    record.original_bands[0] = '\0';
+    writeCellCacheRecord(&record);
+
+    return true;
+}
+
+/**
+ * @brief Records the serving cell in EEPROM after a successful attach.
+ */
+static void updateCellCache(void) {
+
+    CellCacheRecord record;
+    readCellCacheRecord(&record);
+    memset(&record.cell, 0, sizeof(record.cell));
+
+    char response[160] = "";
+    char value[16]     = "";
+
+    // Numeric format for the PLMN. Lte.getOperator() sets it back to the
+    // operator name
+    SequansController.writeCommand(F("AT+COPS=3,2"));
+
+    if (SequansController.writeCommand(F("AT+COPS?"),
+                                       response,
+                                       sizeof(response)) !=
+            ResponseResult::OK ||
+        !SequansController.extractValueFromCommandResponse(response,
+                                                           2,
+                                                           value,
+                                                           sizeof(value))) {
+        return;
     }
 
-    // Get the time from the modem
-    if (SequansController.writeCommand(F("AT+CCLK?"),
-                                       response_buffer,
-                                       sizeof(response_buffer)) !=
+    // Remove the quotes
+    strncpy(record.cell.plmn, value + 1, sizeof(record.cell.plmn) - 1);
+    record.cell.plmn[strcspn(record.cell.plmn, "\"")] = '\0';
+
+    if (SequansController.writeCommand(F("AT+SQNMONI=9"),
+                                       response,
+                                       sizeof(response)) !=
         ResponseResult::OK) {
+        return;
+    }
 
-        Log.error(F("Command for retrieving modem time failed"));
-        Lte.end();
+    const char* earfcn = strstr_P(response, PSTR("EARFCN:"));
 
-        return false;
+    if (earfcn == NULL) {
+        return;
     }
 
-    if (!SequansController.extractValueFromCommandResponse(
-            response_buffer,
-            0,
-            value_buffer,
-            sizeof(value_buffer))) {
+    record.cell.earfcn  = strtoul(earfcn + strlen_P(PSTR("EARFCN:")), NULL, 10);
+    record.cell.band    = bandFromEarfcn(record.cell.earfcn);
+    record.cell.cell_id = Lte.getCellId();
+
+    if (record.cell.band == 0) {
+        return;
+    }
 
-        Log.error(F("Failed to retrieve time from modem"));
-        Lte.end();
+    writeCellCacheRecord(&record);
 
-        return false;
+    Log.debugf(F("Cached cell on PLMN %s, band %u, EARFCN %lu\r\n"),
+               record.cell.plmn,
+               record.cell.band,
+               record.cell.earfcn);
+}
+
+/**
+ * @brief Called when registered after an attach, to record the attach time
+ * and the serving cell.
+ */
+static void attached(void) {
+
+    const uint32_t attach_ms = millis() - attach_start_ms;
+
+    attach_statistics.attaches++;
+    attach_statistics.last_attach_ms = attach_ms;
+
+    if (search_restricted) {
+        attach_statistics.cached_attaches++;
+        attach_statistics.cached_attach_total_ms += attach_ms;
+    } else {
+        attach_statistics.full_scan_attach_total_ms += attach_ms;
     }
 
-    char year[3]  = "";
-    char month[3] = "";
-    char day[3]   = "";
+    if (cell_cache_enabled) {
+        updateCellCache();
+    }
+}
 
-    memcpy(year, &value_buffer[0] + 1, 2);
-    memcpy(month, &value_buffer[0] + 4, 2);
-    memcpy(day, &value_buffer[0] + 7, 2);
+/**
+ * @brief Reached when connected and the time is valid.
+ */
+static void connected(void) {
 
-    // We check the date and whether it is unix epoch start or not
-    if (atoi(year) == 70 && atoi(month) == 1 && atoi(day) == 1) {
+    SequansController.unregisterCallback(FV(TIMEZONE_CALLBACK));
+    SequansController.unregisterCallback(FV(NTP_CALLBACK));
 
-        // Not valid time, have to do sync. First we wait some to see if we get
-        // the timezone URC
-        const TimeoutTimer timezone_timer(TIMEZONE_WAIT_MS);
+    // Anchor the network time again after every attach, as an existing anchor
+    // might have been extrapolated across a power down whilst the modem now
+    // has the time from the network
+    if (!time_anchored) {
+        NetworkTime.sync();
+    }
 
-        while (!timezone_timer.hasTimedOut() && !got_timezone) {}
+    connect_time_ms = millis() - connect_start_ms;
 
-        if (!got_timezone) {
+    setState(LteState::CONNECTED);
+}
 
-            // Do manual sync with NTP server
-            if (print_messages) {
-                Log.info(F("Did not get time from operator, doing NTP sync. "
-                           "This can take some time..."));
-            }
+/**
+ * @brief Checks that the modem has got the time from the operator, and does a
+ * NTP sync if not. Called from #poll() in LteState::TIME_SYNC.
+ */
+static void pollTimeSync(void) {
+
+    if (hasTimedOut(state_start_ms, connect_timeout_ms)) {
+        Log.warnf(F("Did not get NTP sync within timeout of %lu ms. Consider "
+                    "increasing timeout for Lte.begin()\r\n"),
+                  connect_timeout_ms);
+        fail();
+        return;
+    }
+
+    switch (time_sync_step) {
+
+    case TimeSyncStep::CHECK_CLOCK:
+
+        // The modem's clock starts at 1970-01-01 until it gets the time, in
+        // which case we wait some to see if we get the timezone URC
+        if (NetworkTime.sync()) {
+            time_is_valid = true;
+            time_anchored = true;
+        } else {
+            time_sync_step = TimeSyncStep::WAIT_FOR_TIMEZONE;
+            step_start_ms  = millis();
+        }
+
+        break;
+
+    case TimeSyncStep::WAIT_FOR_TIMEZONE:
+
+        if (got_timezone) {
+            time_is_valid = true;
+        } else if (hasTimedOut(step_start_ms, TIMEZONE_WAIT_MS)) {
+            Log.info(F("Did not get time from operator, doing NTP sync. This "
+                       "can take some time..."));
+
+            SequansController.registerCallback(FV(NTP_CALLBACK), ntpCallback);
+            time_sync_step = TimeSyncStep::REQUEST_NTP_SYNC;
+        }
+
+        break;
+
+    case TimeSyncStep::REQUEST_NTP_SYNC:
+
+        // We might be disconnected from the network whilst doing the NTP sync,
+        // so give up if that is the case
+        if (!is_connected) {
+            Log.warn(F("Got disconnected from network whilst doing NTP sync"));
+            fail();
+            return;
+        }
+
+        ntp_status = 0;
+
+        // Perform the actual NTP sync, retried at the next poll if it fails
+        if (SequansController.writeCommand(
+                F("AT+SQNNTP=2,\"time.google.com,time.windows.com,pool.ntp."
+                  "org\",1")) == ResponseResult::OK) {
+            time_sync_step = TimeSyncStep::WAIT_FOR_NTP_SYNC;
+            step_start_ms  = millis();
+        }
+
+        break;
+
+    case TimeSyncStep::WAIT_FOR_NTP_SYNC:
+
+        if (ntp_status == NTP_OK) {
+            Log.info(F("Got NTP sync!"));
+            time_is_valid = true;
+        } else if (ntp_status != 0 ||
+                   hasTimedOut(step_start_ms, WAIT_FOR_URC_TIMEOUT_MS)) {
+            // The sync failed or the URC never came, retry
+            time_sync_step = TimeSyncStep::REQUEST_NTP_SYNC;
+        }
+
+        break;
+    }
+
+    if (time_is_valid) {
+        connected();
+    }
+}
+
+bool LteClass::beginAsync(const uint32_t timeout_ms) {
+
+    connect_start_ms   = millis();
+    connect_timeout_ms = timeout_ms;
+
+    // If low power is utilized, the modem will already be initialized, so don't
+    // reset it by calling begin again
+    if (!SequansController.isInitialized()) {
+        if (!SequansController.begin()) {
+            setState(LteState::FAILED);
+            return false;
+        }
+    }
+
+    // Enable time zone callback
+    SequansController.registerCallback(FV(TIMEZONE_CALLBACK), timezoneCallback);
+
+    // The response of the CEREG query would otherwise be taken for the URC
+    SequansController.unregisterCallback(FV(CEREG_CALLBACK));
+
+    // The settings below are kept by the modem whilst it is running, so they
+    // are only applied if they differ. If the modem is still registered with
+    // CEREG reporting enabled, e.g. after power save, the registration is
+    // reused instead of detaching and attaching again.
+    char functionality = 0;
+    char cereg[2]      = "";
+    char ctzu          = 0;
+    char ctzr          = 0;
+
+    querySettings(F("AT+CFUN?"), &functionality, 1);
+    querySettings(F("AT+CEREG?"), cereg, sizeof(cereg));
+
+    connection_resumed = sim_is_ready && functionality == '1' &&
+                         cereg[0] == '5' &&
+                         (cereg[1] == STAT_REGISTERED_HOME_NETWORK ||
+                          cereg[1] == STAT_REGISTERED_ROAMING);
+
+    time_sync_step = TimeSyncStep::CHECK_CLOCK;
+    time_anchored  = false;
+
+    if (connection_resumed) {
+        SequansController.registerCallback(FV(CEREG_CALLBACK),
+                                           connectionStatus,
+                                           false);
+
+        is_connected = true;
+        LedCtrl.on(Led::CELL, true);
+
+        if (time_is_valid) {
+            connected();
+        } else {
+            setState(LteState::TIME_SYNC);
+        }
+
+        return true;
+    }
 
-            // Will break from this when we get the NTP sync
-
-            const TimeoutTimer ntp_sync_timer(timeout_ms);
-            bool got_ntp_sync = false;
-
-            while (!ntp_sync_timer.hasTimedOut() && !got_ntp_sync) {
-
-                // We might be disconnected from the network whilst doing the
-                // NTP sync, so return if that is the case
-                if (!isConnected()) {
-                    Log.warn(F(
-                        "Got disconnected from network whilst doing NTP sync"));
-                    Lte.end();
-                    return false;
-                }
-
-                // Perform the actual NTP sync
-                if (SequansController.writeCommand(
-                        F("AT+SQNNTP=2,\"time.google.com,time.windows.com,pool."
-                          "ntp.org\",1")) != ResponseResult::OK) {
-                    continue;
-                }
-
-                char buffer[64] = "";
-
-                if (!SequansController.waitForURC(F("SQNNTP"),
-                                                  buffer,
-                                                  sizeof(buffer))) {
-                    // Wait for the NTP URC timed out, retry
-                    continue;
-                }
-
-                if (buffer[NTP_STATUS_INDEX] == NTP_OK) {
-                    Log.info(F("Got NTP sync!"));
-                    got_ntp_sync = true;
-                    break;
-                }
+    // Disconnect before configuration if already connected
+    if (functionality != '0') {
+        SequansController.writeCommand(FV(AT_DISCONNECT));
+    }
+
+    // Enable time zone update
+    querySettings(F("AT+CTZU?"), &ctzu, 1);
+
+    if (ctzu != '1') {
+        SequansController.writeCommand(F("AT+CTZU=1"));
+    }
+
+    // Enable time zone reporting
+    querySettings(F("AT+CTZR?"), &ctzr, 1);
+
+    if (ctzr != '1') {
+        SequansController.writeCommand(F("AT+CTZR=1"));
+    }
+
+    // Enable CEREG URC
+    if (cereg[0] != '5') {
+        SequansController.writeCommand(F("AT+CEREG=5"));
+    }
+
+    // The SIM card is checked after the initial CEREG URC
+    got_cereg = false;
+    SequansController.registerCallback(FV(CEREG_CALLBACK),
+                                       connectionStatus,
+                                       false);
+
+    // Restrict the search to the band of the last known cell, which saves
+    // scanning all the bands
+    LteCellInfo cell;
+    search_restricted = cell_cache_enabled && loadCellCache(&cell) &&
+                        restrictBands(cell.band);
+
+    // Lift the restriction of an earlier attach if it is not wanted now, or
+    // if restricting failed half way
+    if (!search_restricted) {
+        restoreBands();
+    }
+
+    // Start connecting to the operator
+    SequansController.writeCommand(F("AT+CFUN=1"));
+
+    attach_start_ms = millis();
+    setState(LteState::SIM_CHECK);
+
+    return true;
+}
+
+LteState LteClass::poll(void) {
+
+    switch (state) {
+
+    case LteState::SIM_CHECK:
+
+        if (!got_cereg &&
+            !hasTimedOut(state_start_ms, WAIT_FOR_URC_TIMEOUT_MS)) {
+            break;
+        }
+
+        if (!sim_is_ready && !checkSim()) {
+            fail();
+            break;
+        }
+
+        led_toggle_ms = millis();
+        setState(LteState::REGISTERING);
+
+        break;
+
+    case LteState::REGISTERING:
+
+        if (is_connected) {
+            attached();
+
+            if (time_is_valid) {
+                connected();
+            } else {
+                setState(LteState::TIME_SYNC);
             }
+        } else if (search_restricted &&
+                   hasTimedOut(attach_start_ms,
+                               LTE_CELL_CACHE_SEARCH_TIMEOUT_MS)) {
+
+            Log.info(F("Did not find the last known cell, searching all "
+                       "bands"));
+
+            // The band selection only takes effect when detached
+            SequansController.writeCommand(FV(AT_DISCONNECT));
+            restoreBands();
+            SequansController.writeCommand(F("AT+CFUN=1"));
+
+            search_restricted = false;
+            attach_statistics.fallbacks++;
+        } else if (hasTimedOut(state_start_ms, connect_timeout_ms)) {
+            Log.errorf(F("Was not able to connect to the network within the "
+                         "timeout of %lu ms. Consider increasing the timeout "
+                         "or checking your cellular coverage.\r\n"),
+                       connect_timeout_ms);
+
+            // Check the SIM card again the next time, in case it is the cause
+            sim_is_ready = false;
+
+            fail();
+        } else if (hasTimedOut(led_toggle_ms, LED_TOGGLE_INTERVAL_MS)) {
+            LedCtrl.toggle(Led::CELL, true);
+            led_toggle_ms = millis();
+        }
+
+        break;
+
+    case LteState::TIME_SYNC:
+        pollTimeSync();
+        break;
+
+    case LteState::CONNECTED:
+
+        if (!is_connected) {
+            setState(LteState::LOST);
+        }
+
+        break;
+
+    case LteState::LOST:
 
-            if (!got_ntp_sync) {
-                Log.warnf(F("Did not get NTP sync within timeout of %lu ms. "
-                            "Consider increasing timeout for Lte.begin()\r\n"),
-                          timeout_ms);
-                Lte.end();
-                return false;
+        // The modem keeps searching for the network by itself
+        if (is_connected) {
+            setState(LteState::CONNECTED);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+
+    return state;
+}
+
+bool LteClass::begin(const uint32_t timeout_ms, const bool print_messages) {
+
+    if (!beginAsync(timeout_ms)) {
+        return false;
+    }
+
+    LteState previous_state = LteState::OFF;
+    uint32_t dot_ms         = millis();
+
+    while (true) {
+
+        const LteState current_state = poll();
+
+        if (print_messages && current_state != previous_state) {
+            if (current_state == LteState::REGISTERING) {
+                Log.infof(F("Connecting to operator"));
+            } else if (previous_state == LteState::REGISTERING &&
+                       current_state != LteState::FAILED) {
+                Log.rawf(F(" OK!\r\n"));
             }
         }
+
+        if (current_state == LteState::CONNECTED) {
+            break;
+        }
+
+        if (current_state == LteState::FAILED) {
+            return false;
+        }
+
+        if (print_messages && current_state == LteState::REGISTERING &&
+            hasTimedOut(dot_ms, LED_TOGGLE_INTERVAL_MS)) {
+            Log.rawf(F("."));
+            dot_ms = millis();
+        }
+
+        previous_state = current_state;
+
+        _delay_ms(10);
     }
 
-    SequansController.unregisterCallback(FV(TIMEZONE_CALLBACK));
+    if (print_messages) {
+        Log.debugf(F("%S in %lu ms\r\n"),
+                   connection_resumed ? PSTR("Resumed connection")
+                                      : PSTR("Connected"),
+                   connect_time_ms);
+    }
 
     return true;
 }
@@ -294,7 +1027,11 @@ void LteClass::end(void) {
         // hanging URC preventing the modem to shut down
         MqttClient.end();
 
+        // The HTTP profiles are not kept when the modem is powered down
+        HttpClient.end();
+
         SequansController.unregisterCallback(FV(TIMEZONE_CALLBACK));
+        SequansController.unregisterCallback(FV(NTP_CALLBACK));
         SequansController.writeCommand(FV(AT_DISCONNECT));
 
         // Wait for the CEREG URC after disconnect so that the modem doesn't
@@ -306,10 +1043,18 @@ void LteClass::end(void) {
 
         SequansController.clearReceiveBuffer();
         SequansController.end();
+
+        // The modem has to get the time again after it has been shut down
+        time_is_valid = false;
     }
 
     got_timezone = false;
     is_connected = false;
+
+    // A failed attempt is kept as the state, so that it can be told apart
+    if (state != LteState::FAILED) {
+        setState(LteState::OFF);
+    }
 }
 
 String LteClass::getOperator(void) {
@@ -344,3 +1089,41 @@ void LteClass::onDisconnect(void (*disconnect_callback)(void)) {
 }
 
 bool LteClass::isConnected(void) { return is_connected; }
+
+LteState LteClass::getState(void) { return state; }
+
+void LteClass::onStateChange(void (*callback)(const LteState state)) {
+    state_change_callback = callback;
+}
+
+uint32_t LteClass::getConnectTime(void) { return connect_time_ms; }
+
+bool LteClass::wasConnectionResumed(void) { return connection_resumed; }
+
+void LteClass::enableCellCache(const bool enable) {
+    cell_cache_enabled = enable;
+}
+
+bool LteClass::getCachedCell(LteCellInfo* cell) { return loadCellCache(cell); }
+
+void LteClass::clearCellCache(void) {
+
+    // The original band selection is kept, so that it is restored at the next
+    // attach
+    CellCacheRecord record;
+    readCellCacheRecord(&record);
+    memset(&record.cell, 0, sizeof(record.cell));
+    writeCellCacheRecord(&record);
+}
+
+LteAttachStatistics LteClass::getAttachStatistics(void) {
+    return attach_statistics;
+}
+
+uint32_t LteClass::getCellId(void) {
+    cli();
+    const uint32_t id = cell_id;
+    sei();
+
+    return id;
+}
@@ -5,9 +5,67 @@
 #ifndef LTE_H
 #define LTE_H
 
+#include "eeprom_layout.h"
+
 #include <Arduino.h>
 #include <stdint.h>
 
+/**
+ * @brief Time the search for the network is restricted to the band of the last
+ * known cell before falling back to searching all the bands.
+ */
+#define LTE_CELL_CACHE_SEARCH_TIMEOUT_MS (60000UL)
+
+/**
+ * @brief The serving cell, as recorded after an attach.
+ */
+typedef struct {
+    // Mobile country code and mobile network code, e.g. "24201"
+    char plmn[7];
+    uint8_t band;
+    uint32_t earfcn;
+    uint32_t cell_id;
+} LteCellInfo;
+
+/**
+ * @brief Time spent attaching to the network, from starting the search until
+ * registered, split by whether the search was restricted to the band of the
+ * last known cell. Attaches which fell back to searching all the bands count
+ * as full scans, including the time spent on the restricted search.
+ */
+typedef struct {
+    uint16_t attaches;
+    uint16_t cached_attaches;
+    uint16_t fallbacks;
+    uint32_t last_attach_ms;
+    uint32_t cached_attach_total_ms;
+    uint32_t full_scan_attach_total_ms;
+} LteAttachStatistics;
+
+enum class LteState {
+    // Not started, or shut down with LteClass::end()
+    OFF = 0,
+
+    // Waiting for the modem to start searching before checking the SIM card
+    SIM_CHECK,
+
+    // Waiting for the modem to register with the operator
+    REGISTERING,
+
+    // Registered, waiting for the time from the operator or a NTP sync
+    TIME_SYNC,
+
+    CONNECTED,
+
+    // The connection was lost after having been connected. The modem keeps
+    // searching, and the state goes back to CONNECTED when it registers again
+    LOST,
+
+    // The last attempt to connect failed or timed out, and the modem has been
+    // shut down
+    FAILED
+};
+
 class LteClass {
 
   private:
@@ -28,7 +86,9 @@ class LteClass {
 
     /**
      * @brief Initializes the LTE module and its controller interface. Connects
-     * to the network.
+     * to the network. If the modem is already running and registered, e.g.
+     * after power save, the registration is reused, and configuration which
+     * the modem already has is not applied again.
      *
      * @param timeout_ms The amount of time to wait for connection before
      * aborting.
@@ -40,6 +100,37 @@ class LteClass {
     bool begin(const uint32_t timeout_ms = 600000,
                const bool print_messages = true);
 
+    /**
+     * @brief Starts connecting to the network like #begin(), but returns as
+     * soon as the modem has been started and configured. The connection is
+     * then driven by #poll(), which has to be called regularly, e.g. from the
+     * application's loop.
+     *
+     * @param timeout_ms The amount of time to wait for the registration and
+     * the time synchronization, each, before giving up.
+     *
+     * @return False if the modem could not be started.
+     */
+    bool beginAsync(const uint32_t timeout_ms = 600000);
+
+    /**
+     * @brief Advances the connection based on the URCs received from the
+     * modem. Returns right away, apart from the commands sent to the modem
+     * when moving on from one state to the next. The state change callback is
+     * called from here.
+     *
+     * @return The current state.
+     */
+    LteState poll(void);
+
+    LteState getState(void);
+
+    /**
+     * @brief Registers a callback which is called from #poll() (or #end())
+     * every time the state changes.
+     */
+    void onStateChange(void (*callback)(const LteState state));
+
     /**
      * @brief Disables the interface with the LTE module. Disconnects from
      * operator.
@@ -58,6 +149,52 @@ class LteClass {
     void onDisconnect(void (*disconnect_callback)(void));
 
     bool isConnected(void);
+
+    /**
+     * @return Time in milliseconds the last successful #begin() took, from
+     * starting the modem until connected and the time is synchronized.
+     */
+    uint32_t getConnectTime(void);
+
+    /**
+     * @return True if the last successful #begin() reused an existing
+     * registration instead of attaching again.
+     */
+    bool wasConnectionResumed(void);
+
+    /**
+     * @return The ID of the serving cell as reported by the last CEREG URC, or
+     * 0 if it isn't known or not registered.
+     */
+    uint32_t getCellId(void);
+
+    /**
+     * @brief Enables caching of the last known cell. After every attach, the
+     * PLMN, band and EARFCN of the serving cell are persisted in EEPROM, and
+     * the next attach searches only that band. If the network is not found
+     * within #LTE_CELL_CACHE_SEARCH_TIMEOUT_MS, the band selection the modem
+     * had before is restored and searched instead.
+     *
+     * @note The restriction stays in place whilst connected. The original
+     * band selection is persisted as well, and restored by the next attach
+     * done without the cache, also after a reset.
+     */
+    void enableCellCache(const bool enable = true);
+
+    /**
+     * @brief Retrieves the last known cell from EEPROM.
+     *
+     * @return false if no cell has been cached.
+     */
+    bool getCachedCell(LteCellInfo* cell);
+
+    /**
+     * @brief Clears the last known cell. The original band selection of the
+     * modem is restored at the next attach.
+     */
+    void clearCellCache(void);
+
+    LteAttachStatistics getAttachStatistics(void);
 };
 
 extern LteClass Lte;
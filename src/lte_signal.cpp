@@ -0,0 +1,198 @@
+#include "lte_signal.h"
+#include "log.h"
+#include "lte.h"
+#include "sequans_controller.h"
+
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Indices of the RSRQ and RSRP in the response of AT+CESQ
+#define CESQ_RSRQ_INDEX 4
+#define CESQ_RSRP_INDEX 5
+
+// Value AT+CESQ reports for a metric which is not known
+#define CESQ_UNKNOWN 255
+
+LteSignalClass LteSignal = LteSignalClass::instance();
+
+static LteSignalSample history[LTE_SIGNAL_HISTORY_SIZE];
+static uint8_t history_head  = 0;
+static uint8_t history_count = 0;
+
+static uint32_t sample_interval_ms = LTE_SIGNAL_SAMPLE_INTERVAL_MS;
+
+/**
+ * @brief Retrieves the value at @p index of a AT+CESQ response.
+ *
+ * @return The value, or #CESQ_UNKNOWN if it could not be retrieved.
+ */
+static uint8_t cesqValue(char* response, const uint8_t index) {
+
+    char value_buffer[8] = "";
+
+    if (!SequansController.extractValueFromCommandResponse(
+            response,
+            index,
+            value_buffer,
+            sizeof(value_buffer))) {
+        return CESQ_UNKNOWN;
+    }
+
+    return atoi(value_buffer);
+}
+
+/**
+ * @brief Retrieves the SINR from the serving cell information of the modem,
+ * where it is reported as CINR with decimals.
+ */
+static int16_t querySinr(void) {
+
+    char response[160] = "";
+
+    if (SequansController.writeCommand(F("AT+SQNMONI=9"),
+                                       response,
+                                       sizeof(response)) !=
+        ResponseResult::OK) {
+        return LTE_SIGNAL_UNKNOWN;
+    }
+
+    const char* cinr = strstr_P(response, PSTR("CINR:"));
+
+    if (cinr == NULL) {
+        return LTE_SIGNAL_UNKNOWN;
+    }
+
+    return strtol(cinr + strlen_P(PSTR("CINR:")), NULL, 10);
+}
+
+bool LteSignalClass::sample(void) {
+
+    if (!Lte.isConnected()) {
+        return false;
+    }
+
+    char response[64] = "";
+
+    if (SequansController.writeCommand(F("AT+CESQ"),
+                                       response,
+                                       sizeof(response)) !=
+        ResponseResult::OK) {
+        Log.warn(F("Failed to retrieve the signal quality"));
+        return false;
+    }
+
+    const uint8_t rsrq = cesqValue(response, CESQ_RSRQ_INDEX);
+    const uint8_t rsrp = cesqValue(response, CESQ_RSRP_INDEX);
+
+    if (rsrp == CESQ_UNKNOWN) {
+        return false;
+    }
+
+    LteSignalSample& entry = history[history_head];
+
+    // The RSRP is reported in steps of 1 dBm from -140 dBm and the RSRQ in
+    // steps of 0.5 dB from -19.5 dB, see 3GPP TS 27.007
+    entry.timestamp_ms = millis();
+    entry.rsrp         = (int16_t)rsrp - 141;
+    entry.rsrq         = rsrq == CESQ_UNKNOWN ? LTE_SIGNAL_UNKNOWN
+                                              : (rsrq / 2) - 20;
+    entry.sinr         = querySinr();
+    entry.cell_id      = Lte.getCellId();
+
+    history_head = (history_head + 1) % LTE_SIGNAL_HISTORY_SIZE;
+
+    if (history_count < LTE_SIGNAL_HISTORY_SIZE) {
+        history_count++;
+    }
+
+    Log.debugf(F("Signal: RSRP %d dBm, RSRQ %d dB, SINR %d dB, cell %lX\r\n"),
+               entry.rsrp,
+               entry.rsrq,
+               entry.sinr,
+               entry.cell_id);
+
+    return true;
+}
+
+bool LteSignalClass::poll(const uint32_t interval_ms) {
+
+    sample_interval_ms = interval_ms;
+
+    LteSignalSample latest;
+
+    if (getLatest(&latest) && millis() - latest.timestamp_ms < interval_ms) {
+        return false;
+    }
+
+    return sample();
+}
+
+bool LteSignalClass::getLatest(LteSignalSample* sample) {
+
+    if (history_count == 0) {
+        return false;
+    }
+
+    *sample = history[(history_head + LTE_SIGNAL_HISTORY_SIZE - 1) %
+                      LTE_SIGNAL_HISTORY_SIZE];
+
+    return true;
+}
+
+uint8_t LteSignalClass::getHistory(LteSignalSample* samples,
+                                   const uint8_t max_samples) {
+
+    const uint8_t count = min(history_count, max_samples);
+
+    // Skip the oldest ones if not all of them fit
+    const uint8_t first = history_head + LTE_SIGNAL_HISTORY_SIZE - count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        samples[i] = history[(first + i) % LTE_SIGNAL_HISTORY_SIZE];
+    }
+
+    return count;
+}
+
+int16_t LteSignalClass::getAverageRsrp(void) {
+
+    if (history_count == 0) {
+        return LTE_SIGNAL_UNKNOWN;
+    }
+
+    int32_t sum = 0;
+
+    for (uint8_t i = 0; i < history_count; i++) {
+        sum += history[i].rsrp;
+    }
+
+    return sum / history_count;
+}
+
+bool LteSignalClass::isGoodTimeToTransmit(void) {
+
+    LteSignalSample latest;
+
+    if (!Lte.isConnected() || !getLatest(&latest) ||
+        millis() - latest.timestamp_ms >= 2 * sample_interval_ms) {
+        return false;
+    }
+
+    if (latest.sinr != LTE_SIGNAL_UNKNOWN &&
+        latest.sinr < LTE_SIGNAL_MIN_SINR_DB) {
+        return false;
+    }
+
+    if (latest.rsrp >= LTE_SIGNAL_GOOD_RSRP_DBM) {
+        return true;
+    }
+
+    return latest.rsrp >= LTE_SIGNAL_MIN_RSRP_DBM &&
+           latest.rsrp >= getAverageRsrp();
+}
+
+void LteSignalClass::clear(void) {
+    history_head  = 0;
+    history_count = 0;
+}
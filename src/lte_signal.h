@@ -0,0 +1,128 @@
+/**
+ * @brief Radio link quality telemetry. Samples the signal quality of the
+ * serving cell from the modem and keeps a short history of it, which is used
+ * to tell whether it is a good time to transmit. Uploads done whilst the signal
+ * is strong take less energy per byte and are retried less.
+ */
+
+#ifndef LTE_SIGNAL_H
+#define LTE_SIGNAL_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * @brief Amount of samples kept in the history.
+ */
+#define LTE_SIGNAL_HISTORY_SIZE (8)
+
+/**
+ * @brief Default interval between the samples taken by
+ * LteSignalClass::poll().
+ */
+#define LTE_SIGNAL_SAMPLE_INTERVAL_MS (60000UL)
+
+/**
+ * @brief RSRP at or above which the signal is always regarded as good enough
+ * to transmit.
+ */
+#define LTE_SIGNAL_GOOD_RSRP_DBM (-100)
+
+/**
+ * @brief RSRP and SINR below which it is never regarded as a good time to
+ * transmit.
+ */
+#define LTE_SIGNAL_MIN_RSRP_DBM (-120)
+#define LTE_SIGNAL_MIN_SINR_DB  (0)
+
+/**
+ * @brief Value of a metric the modem did not report.
+ */
+#define LTE_SIGNAL_UNKNOWN (INT16_MIN)
+
+typedef struct {
+    // When the sample was taken, from millis()
+    uint32_t timestamp_ms;
+
+    // Reference signal received power in dBm
+    int16_t rsrp;
+
+    // Reference signal received quality in dB
+    int16_t rsrq;
+
+    // Signal to interference and noise ratio in dB
+    int16_t sinr;
+
+    // ID of the serving cell, 0 if not known
+    uint32_t cell_id;
+} LteSignalSample;
+
+class LteSignalClass {
+
+  private:
+    LteSignalClass(){};
+
+  public:
+    static LteSignalClass& instance(void) {
+        static LteSignalClass instance;
+        return instance;
+    }
+
+    /**
+     * @brief Samples the signal quality from the modem and adds it to the
+     * history. Requires the modem to be started with Lte.begin().
+     *
+     * @return false if not connected or the modem did not report the signal
+     * quality.
+     */
+    bool sample(void);
+
+    /**
+     * @brief Takes a sample if @p interval_ms has passed since the last one.
+     * Meant to be called regularly from the application's loop.
+     *
+     * @return true if a sample was taken.
+     */
+    bool poll(const uint32_t interval_ms = LTE_SIGNAL_SAMPLE_INTERVAL_MS);
+
+    /**
+     * @brief Retrieves the last sample.
+     *
+     * @return false if there are no samples.
+     */
+    bool getLatest(LteSignalSample* sample);
+
+    /**
+     * @brief Copies the history to @p samples, the oldest sample first.
+     *
+     * @return The number of samples copied, at most @p max_samples.
+     */
+    uint8_t getHistory(LteSignalSample* samples, const uint8_t max_samples);
+
+    /**
+     * @return The average RSRP of the samples in the history, or
+     * #LTE_SIGNAL_UNKNOWN if there are none.
+     */
+    int16_t getAverageRsrp(void);
+
+    /**
+     * @brief Tells whether the signal is good enough to transmit, for deferring
+     * uploads which can wait. This is the case if connected and the last
+     * sample is no older than two sample intervals, and:
+     * - the RSRP is at or above #LTE_SIGNAL_GOOD_RSRP_DBM, or
+     * - the RSRP is at or above the average of the history and above
+     * #LTE_SIGNAL_MIN_RSRP_DBM, i.e. not in a dip.
+     *
+     * The SINR has to be at or above #LTE_SIGNAL_MIN_SINR_DB if it is known.
+     */
+    bool isGoodTimeToTransmit(void);
+
+    /**
+     * @brief Clears the history.
+     */
+    void clear(void);
+};
+
+extern LteSignalClass LteSignal;
+
+#endif
@@ -3,15 +3,19 @@
 #include "flash_string.h"
 #include "led_ctrl.h"
 #include "log.h"
+#include "low_power.h"
 #include "lte.h"
 #include "security_profile.h"
 #include "sequans_controller.h"
+#include "timeout_timer.h"
 
+#include <avr/eeprom.h>
 #include <avr/pgmspace.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <util/delay.h>
 
 #define MQTT_PUBLISH_URC_LENGTH   (32)
 #define MQTT_SUBSCRIBE_URC_LENGTH (164)
@@ -23,6 +27,7 @@
 #define MQTT_TLS_SECURITY_PROFILE_ID     (2)
 #define MQTT_TLS_ECC_SECURITY_PROFILE_ID (1)
 
+#define MQTT_URC_MESSAGE_ID_INDEX  (1)
 #define MQTT_URC_STATUS_CODE_INDEX (2)
 #define STATUS_CODE_INVALID_VALUE  (3)
 #define NUM_STATUS_CODES           (18)
@@ -30,15 +35,56 @@
 #define HCESIGN_DIGEST_LENGTH (64)
 #define HCESIGN_CTX_ID_LENGTH (5)
 
+// Context ID, key ID, digest length and digest of the sign URC
+#define MQTT_SIGN_URC_LENGTH (128)
+
+// Context ID, message length, QoS and message ID around the topic of the
+// receive URC, e.g. 0,"<topic>",1024,2,4294967295
+#define MQTT_ON_MESSAGE_URC_OVERHEAD (32)
+
+#define MQTT_URC_BUFFER_SIZE                                             \
+    (MQTT_TOPIC_MAX_LENGTH + MQTT_ON_MESSAGE_URC_OVERHEAD >              \
+             MQTT_SIGN_URC_LENGTH                                        \
+         ? MQTT_TOPIC_MAX_LENGTH + MQTT_ON_MESSAGE_URC_OVERHEAD          \
+         : MQTT_SIGN_URC_LENGTH)
+
 #define MQTT_TIMEOUT_MS (2000)
 
+#define DELIVERY_STATE_TABLE_MAGIC (0xA5)
+
+#define MQTT_STREAM_READ_TIMEOUT_MS (2000)
+
+// The modem terminates the message with a carriage return and line feed
+// followed by the OK or ERROR termination, so we have to hold back this many
+// bytes before we know that they are part of the payload
+#define MQTT_STREAM_HOLD_BACK_SIZE (11)
+
+#define MQTT_TOPIC_LEVEL_SEPARATOR  '/'
+#define MQTT_SINGLE_LEVEL_WILDCARD  '+'
+#define MQTT_MULTI_LEVEL_WILDCARD   '#'
+#define MQTT_SYSTEM_TOPIC_CHARACTER '$'
+
+#define TOPIC_TRIE_NO_NODE (0xFF)
+
+#define MQTT_RECONNECT_ATTEMPT_TIMEOUT_MS (30000)
+#define MQTT_RECONNECT_MAX_BACKOFF_SHIFT  (16)
+
+// Topic index, message ID and message length
+#define INBOUND_HEADER_SIZE (sizeof(uint8_t) + sizeof(int32_t) + sizeof(uint16_t))
+
 const char MQTT_RECEIVE[] PROGMEM = "AT+SQNSMQTTRCVMESSAGE=0,\"%s\"";
 const char MQTT_RECEIVE_WITH_MSG_ID[] PROGMEM =
     "AT+SQNSMQTTRCVMESSAGE=0,\"%s\",%u";
 const char MQTT_ON_MESSAGE_URC[] PROGMEM    = "SQNSMQTTONMESSAGE";
 const char MQTT_ON_DISCONNECT_URC[] PROGMEM = "SQNSMQTTONDISCONNECT";
+const char MQTT_ON_SUBSCRIBE_URC[] PROGMEM  = "SQNSMQTTONSUBSCRIBE";
+const char MQTT_SUBSCRIBE[] PROGMEM         = "AT+SQNSMQTTSUBSCRIBE=0,\"%s\",%u";
 const char MQTT_DISCONNECT[] PROGMEM        = "AT+SQNSMQTTDISCONNECT=0";
-const char HCESIGN[] PROGMEM                = "AT+SQNHCESIGN=%u,0,64,\"%s\"";
+const char MQTT_ON_CONNECT_URC[] PROGMEM    = "SQNSMQTTONCONNECT";
+const char MQTT_SIGN_URC[] PROGMEM          = "SQNHCESIGN";
+const char MQTT_PUBLISH_PREFIX[] PROGMEM    = "AT+SQNSMQTTPUBLISH=0,\"";
+const char HCESIGN_PREFIX[] PROGMEM         = "AT+SQNHCESIGN=";
+const char HCESIGN_INFIX[] PROGMEM          = ",0,64,\"";
 
 static const char STATUS_CODE_SUCCESS[] PROGMEM       = "Success";
 static const char STATUS_CODE_NOMEM[] PROGMEM         = "No memory";
@@ -100,32 +146,1007 @@ static char topic_buffer[MQTT_TOPIC_MAX_LENGTH + 3];
 
 /**
  * @brief Used when waiting for URCs and for the receive callback. Functions as
- * a temporary buffer to store data.
+ * a temporary buffer to store data. Sized for the largest URC the client
+ * handles instead of the URC buffer of the modem driver.
+ */
+static char urc_buffer[MQTT_URC_BUFFER_SIZE + 1];
+
+/**
+ * @brief States of the reconnect engine driven by MqttClientClass::poll().
+ */
+enum class ReconnectState : uint8_t {
+    IDLE,
+    BACKING_OFF,
+    CONNECTING,
+    REPLAYING_SUBSCRIPTIONS,
+    CONNECTED
+};
+
+/**
+ * @brief The configuration from the last call to MqttClientClass::begin(). The
+ * strings (client ID, host, username and password) are stored at the given
+ * offsets in #reconnect_config_pool.
+ */
+typedef struct {
+    uint16_t offsets[4];
+    uint16_t port;
+    uint16_t keep_alive;
+    bool use_tls;
+    bool use_ecc;
+    bool valid;
+} ReconnectConfig;
+
+static ReconnectConfig reconnect_config = {};
+static char reconnect_config_pool[MQTT_RECONNECT_CONFIG_POOL_SIZE];
+
+static bool reconnect_enabled              = false;
+static ReconnectState reconnect_state      = ReconnectState::IDLE;
+static uint32_t reconnect_min_backoff_ms   = MQTT_RECONNECT_MIN_BACKOFF_MS;
+static uint32_t reconnect_max_backoff_ms   = MQTT_RECONNECT_MAX_BACKOFF_MS;
+static uint8_t reconnect_attempt           = 0;
+static uint32_t reconnect_backoff_ms       = 0;
+static uint32_t reconnect_backoff_start_ms = 0;
+static uint32_t reconnect_attempt_start_ms = 0;
+static uint32_t connection_lost_ms         = 0;
+static bool reconnect_random_seeded        = false;
+
+static volatile bool reconnect_got_sign_request    = false;
+static volatile bool reconnect_got_connect_response = false;
+static volatile int8_t reconnect_connect_status     = -1;
+
+static MqttReconnectStatistics reconnect_statistics = {};
+
+/**
+ * @brief Used by the String version of MqttClientClass::readMessage() to
+ * collect the chunks from MqttClientClass::streamMessage().
+ */
+static String* stream_string_destination = NULL;
+static uint16_t stream_string_capacity    = 0;
+
+static void (*disconnected_callback)(void)                = NULL;
+static void (*receive_callback)(const char* topic,
+                                const uint16_t message_length,
+                                const int32_t message_id) = NULL;
+static void (*receive_topic_handle_callback)(const char* topic,
+                                             const int8_t topic_handle,
+                                             const uint16_t message_length,
+                                             const int32_t message_id) = NULL;
+
+/**
+ * @brief A node in the subscription trie. Every node represents one level of a
+ * topic filter. The children of a node are kept as a linked list through
+ * #next_sibling, so that the nodes can be stored in a fixed array and linked
+ * with one byte indices instead of pointers.
+ */
+typedef struct {
+    /**
+     * @brief Offset of the level name in #topic_trie_pool. The name is not
+     * NULL terminated, so #level_length has to be used.
+     */
+    uint8_t level_offset;
+    uint8_t level_length;
+    uint8_t first_child;
+    uint8_t next_sibling;
+
+    /**
+     * @brief Handler for messages matching the topic filter ending at this
+     * node, NULL if no topic filter ends here.
+     */
+    void (*handler)(const char* topic,
+                    const uint16_t message_length,
+                    const int32_t message_id);
+} TopicTrieNode;
+
+static TopicTrieNode topic_trie_nodes[MQTT_TOPIC_TRIE_MAX_NODES];
+static uint8_t topic_trie_num_nodes = 0;
+static uint8_t topic_trie_root      = TOPIC_TRIE_NO_NODE;
+
+/**
+ * @brief Holds the level names of the nodes in the trie. Level names are
+ * interned, so that a name used in several topic filters is only stored once.
+ */
+static char topic_trie_pool[MQTT_TOPIC_TRIE_POOL_SIZE];
+static uint16_t topic_trie_pool_length = 0;
+
+static bool topicTrieLevelEquals(const uint8_t node,
+                                 const char* level,
+                                 const uint8_t level_length) {
+    return topic_trie_nodes[node].level_length == level_length &&
+           memcmp(&topic_trie_pool[topic_trie_nodes[node].level_offset],
+                  level,
+                  level_length) == 0;
+}
+
+static bool topicTrieLevelIsWildcard(const uint8_t node, const char wildcard) {
+    return topic_trie_nodes[node].level_length == 1 &&
+           topic_trie_pool[topic_trie_nodes[node].level_offset] == wildcard;
+}
+
+/**
+ * @brief Allocates a new node for the given level, re-using the level name in
+ * the pool if another node already has the same name.
+ *
+ * @return The index of the node or #TOPIC_TRIE_NO_NODE if there is no space
+ * left.
+ */
+static uint8_t topicTrieAllocateNode(const char* level,
+                                     const uint8_t level_length) {
+
+    if (topic_trie_num_nodes == MQTT_TOPIC_TRIE_MAX_NODES) {
+        return TOPIC_TRIE_NO_NODE;
+    }
+
+    int16_t level_offset = -1;
+
+    for (uint8_t i = 0; i < topic_trie_num_nodes; i++) {
+        if (topicTrieLevelEquals(i, level, level_length)) {
+            level_offset = topic_trie_nodes[i].level_offset;
+            break;
+        }
+    }
+
+    if (level_offset < 0) {
+
+        // The offset is stored in one byte, so the level has to start within
+        // the first 256 bytes of the pool
+        if (topic_trie_pool_length + level_length >
+                MQTT_TOPIC_TRIE_POOL_SIZE ||
+            topic_trie_pool_length > UINT8_MAX) {
+            return TOPIC_TRIE_NO_NODE;
+        }
+
+        level_offset = topic_trie_pool_length;
+        memcpy(&topic_trie_pool[topic_trie_pool_length], level, level_length);
+        topic_trie_pool_length += level_length;
+    }
+
+    const uint8_t node = topic_trie_num_nodes++;
+
+    topic_trie_nodes[node].level_offset = (uint8_t)level_offset;
+    topic_trie_nodes[node].level_length = level_length;
+    topic_trie_nodes[node].first_child  = TOPIC_TRIE_NO_NODE;
+    topic_trie_nodes[node].next_sibling = TOPIC_TRIE_NO_NODE;
+    topic_trie_nodes[node].handler      = NULL;
+
+    return node;
+}
+
+/**
+ * @brief Inserts the topic filter in the trie and sets @p handler for it. If
+ * the topic filter already exists, the handler is replaced. Passing NULL as
+ * the handler thus removes the handler for the topic filter.
+ *
+ * @return false if the topic filter is invalid or if there is no space left
+ * in the trie.
+ */
+static bool
+topicTrieInsert(const char* topic,
+                void (*handler)(const char* topic,
+                                const uint16_t message_length,
+                                const int32_t message_id)) {
+
+    // Hold the pointer to the index of the first node in the list of siblings
+    // we are searching through, so that a new node can be linked in
+    uint8_t* siblings = &topic_trie_root;
+    uint8_t node      = TOPIC_TRIE_NO_NODE;
+    const char* level = topic;
+
+    while (true) {
+        const char* level_end = strchr(level, MQTT_TOPIC_LEVEL_SEPARATOR);
+        const size_t level_length = level_end == NULL ? strlen(level)
+                                                      : level_end - level;
+
+        if (level_length > UINT8_MAX) {
+            return false;
+        }
+
+        // Wildcards have to occupy an entire level and the multi level
+        // wildcard has to be the last level
+        const char* wildcard = strpbrk(level, "+#");
+
+        if (wildcard != NULL && wildcard < level + level_length &&
+            (level_length != 1 ||
+             (*wildcard == MQTT_MULTI_LEVEL_WILDCARD && level_end != NULL))) {
+            return false;
+        }
+
+        node = *siblings;
+
+        while (node != TOPIC_TRIE_NO_NODE &&
+               !topicTrieLevelEquals(node, level, level_length)) {
+            node = topic_trie_nodes[node].next_sibling;
+        }
+
+        if (node == TOPIC_TRIE_NO_NODE) {
+            node = topicTrieAllocateNode(level, level_length);
+
+            if (node == TOPIC_TRIE_NO_NODE) {
+                return false;
+            }
+
+            topic_trie_nodes[node].next_sibling = *siblings;
+            *siblings                           = node;
+        }
+
+        if (level_end == NULL) {
+            break;
+        }
+
+        siblings = &topic_trie_nodes[node].first_child;
+        level    = level_end + 1;
+    }
+
+    topic_trie_nodes[node].handler = handler;
+
+    return true;
+}
+
+static bool topicTrieCallHandler(const uint8_t node,
+                                 const char* topic,
+                                 const uint16_t message_length,
+                                 const int32_t message_id) {
+
+    if (topic_trie_nodes[node].handler == NULL) {
+        return false;
+    }
+
+    topic_trie_nodes[node].handler(topic, message_length, message_id);
+    return true;
+}
+
+/**
+ * @brief Walks the trie along the levels of @p topic and calls the handlers of
+ * the topic filters matching it.
+ *
+ * @param first_node First node in the list of siblings to match @p level
+ * against.
+ * @param level The start of the current level in @p topic.
+ *
+ * @return true if at least one handler was called.
+ */
+static bool topicTrieDispatch(const uint8_t first_node,
+                              const char* level,
+                              const char* topic,
+                              const uint16_t message_length,
+                              const int32_t message_id) {
+
+    const char* level_end = strchr(level, MQTT_TOPIC_LEVEL_SEPARATOR);
+    const size_t level_length = level_end == NULL ? strlen(level)
+                                                  : level_end - level;
+
+    // Topics starting with $ are reserved for the broker and are not matched
+    // by wildcards in the first level
+    const bool wildcards_allowed = !(level == topic &&
+                                     *topic == MQTT_SYSTEM_TOPIC_CHARACTER);
+
+    bool dispatched = false;
+
+    for (uint8_t node = first_node; node != TOPIC_TRIE_NO_NODE;
+         node         = topic_trie_nodes[node].next_sibling) {
+
+        if (wildcards_allowed &&
+            topicTrieLevelIsWildcard(node, MQTT_MULTI_LEVEL_WILDCARD)) {
+            dispatched |= topicTrieCallHandler(node,
+                                               topic,
+                                               message_length,
+                                               message_id);
+            continue;
+        }
+
+        const bool level_matches =
+            (wildcards_allowed &&
+             topicTrieLevelIsWildcard(node, MQTT_SINGLE_LEVEL_WILDCARD)) ||
+            (level_length <= UINT8_MAX &&
+             topicTrieLevelEquals(node, level, level_length));
+
+        if (!level_matches) {
+            continue;
+        }
+
+        if (level_end != NULL) {
+            dispatched |= topicTrieDispatch(topic_trie_nodes[node].first_child,
+                                            level_end + 1,
+                                            topic,
+                                            message_length,
+                                            message_id);
+            continue;
+        }
+
+        dispatched |= topicTrieCallHandler(node,
+                                           topic,
+                                           message_length,
+                                           message_id);
+
+        // The multi level wildcard also matches the parent level, so e.g.
+        // "sensors/#" matches "sensors"
+        for (uint8_t child = topic_trie_nodes[node].first_child;
+             child != TOPIC_TRIE_NO_NODE;
+             child = topic_trie_nodes[child].next_sibling) {
+
+            if (topicTrieLevelIsWildcard(child, MQTT_MULTI_LEVEL_WILDCARD)) {
+                dispatched |= topicTrieCallHandler(child,
+                                                   topic,
+                                                   message_length,
+                                                   message_id);
+            }
+        }
+    }
+
+    return dispatched;
+}
+
+/**
+ * @brief A subscription remembered for replay when connecting again.
+ */
+typedef struct {
+    /**
+     * @brief Offset of the NULL terminated topic in #subscription_pool.
+     */
+    uint8_t topic_offset;
+    MqttQoS quality_of_service;
+} Subscription;
+
+static Subscription subscriptions[MQTT_MAX_SUBSCRIPTIONS];
+static uint8_t num_subscriptions = 0;
+
+static char subscription_pool[MQTT_SUBSCRIPTION_POOL_SIZE];
+static uint16_t subscription_pool_length = 0;
+
+/**
+ * @brief Number of subscribe confirmations received and how many of them
+ * reported an error whilst replaying the subscriptions.
+ */
+static volatile uint8_t subscribe_confirmations       = 0;
+static volatile uint8_t subscribe_confirmation_errors = 0;
+static uint8_t subscriptions_requested                = 0;
+static uint32_t subscription_replay_start_ms          = 0;
+
+/**
+ * @brief Remembers a subscription, or updates the QoS if the topic already is
+ * remembered.
+ *
+ * @return false if there is no space left for the subscription.
+ */
+static bool rememberSubscription(const char* topic,
+                                 const MqttQoS quality_of_service) {
+
+    for (uint8_t i = 0; i < num_subscriptions; i++) {
+        if (strcmp(&subscription_pool[subscriptions[i].topic_offset], topic) ==
+            0) {
+            subscriptions[i].quality_of_service = quality_of_service;
+            return true;
+        }
+    }
+
+    const size_t topic_size = strlen(topic) + 1;
+
+    // The offset is stored in one byte, so the topic has to start within the
+    // first 256 bytes of the pool
+    if (num_subscriptions == MQTT_MAX_SUBSCRIPTIONS ||
+        subscription_pool_length + topic_size > MQTT_SUBSCRIPTION_POOL_SIZE ||
+        subscription_pool_length > UINT8_MAX) {
+        return false;
+    }
+
+    strcpy(&subscription_pool[subscription_pool_length], topic);
+
+    subscriptions[num_subscriptions].topic_offset = subscription_pool_length;
+    subscriptions[num_subscriptions].quality_of_service = quality_of_service;
+
+    num_subscriptions++;
+    subscription_pool_length += topic_size;
+
+    return true;
+}
+
+static void subscribeConfirmationCallback(char* urc_data) {
+
+    // At most we can have two character ("-x"). We add an extra for null
+    // termination
+    char status_code_buffer[3] = "";
+
+    if (!SequansController.extractValueFromCommandResponse(
+            urc_data,
+            MQTT_URC_STATUS_CODE_INDEX,
+            status_code_buffer,
+            sizeof(status_code_buffer),
+            (char)NULL) ||
+        atoi(status_code_buffer) != 0) {
+        subscribe_confirmation_errors++;
+    }
+
+    subscribe_confirmations++;
+}
+
+/**
+ * @brief Issues the subscribe commands for all the remembered subscriptions
+ * back to back, so that we only wait for one round trip to the broker. The
+ * confirmations are collected by subscribeConfirmationCallback() until
+ * finishSubscriptionReplay() is called.
+ */
+static void requestSubscriptionReplay(void) {
+
+    subscribe_confirmations       = 0;
+    subscribe_confirmation_errors = 0;
+    subscriptions_requested       = 0;
+    subscription_replay_start_ms  = millis();
+
+    SequansController.registerCallback(FV(MQTT_ON_SUBSCRIBE_URC),
+                                       subscribeConfirmationCallback);
+
+    for (uint8_t i = 0; i < num_subscriptions; i++) {
+
+        const char* topic = &subscription_pool[subscriptions[i].topic_offset];
+
+        const ResponseResult subscribe_result = SequansController.writeCommand(
+            FV(MQTT_SUBSCRIBE),
+            NULL,
+            0,
+            topic,
+            subscriptions[i].quality_of_service);
+
+        if (subscribe_result != ResponseResult::OK) {
+            Log.errorf(F("Failed to send subscribe command for topic %s, "
+                         "error code: %X\r\n"),
+                       topic,
+                       static_cast<uint8_t>(subscribe_result));
+            continue;
+        }
+
+        subscriptions_requested++;
+    }
+}
+
+/**
+ * @return true if all the confirmations of the replay have been received or
+ * the replay has timed out.
+ */
+static bool isSubscriptionReplayDone(void) {
+    return subscribe_confirmations >= subscriptions_requested ||
+           millis() - subscription_replay_start_ms >= WAIT_FOR_URC_TIMEOUT_MS;
+}
+
+/**
+ * @brief Stops collecting the confirmations of the replay.
+ *
+ * @return true if all the subscriptions were confirmed without errors.
+ */
+static bool finishSubscriptionReplay(void) {
+
+    SequansController.unregisterCallback(FV(MQTT_ON_SUBSCRIBE_URC));
+
+    if (subscribe_confirmations < subscriptions_requested) {
+        Log.errorf(F("Timed out waiting for subscribe confirmations, got %d "
+                     "of %d\r\n"),
+                   subscribe_confirmations,
+                   subscriptions_requested);
+        return false;
+    }
+
+    if (subscribe_confirmation_errors > 0) {
+        Log.errorf(F("%d of %d subscriptions were not accepted by the "
+                     "broker\r\n"),
+                   subscribe_confirmation_errors,
+                   subscriptions_requested);
+        return false;
+    }
+
+    return subscriptions_requested == num_subscriptions;
+}
+
+/**
+ * @brief Replays the subscriptions and waits for the confirmations.
+ *
+ * @return true if all the subscriptions were confirmed without errors.
+ */
+static bool replaySubscriptions(void) {
+
+    requestSubscriptionReplay();
+
+    while (!isSubscriptionReplayDone()) { _delay_ms(1); }
+
+    return finishSubscriptionReplay();
+}
+
+/**
+ * @brief A message notified by the modem which has not yet been fetched into
+ * the inbound queue.
+ */
+typedef struct {
+    uint8_t topic_index;
+    int32_t message_id;
+    uint16_t message_length;
+} InboundAnnouncement;
+
+static volatile bool inbound_queue_enabled = false;
+
+/**
+ * @brief Interned topics for the messages in the inbound queue. A slot is free
+ * when no announcement or queued message references it.
+ */
+static char inbound_topics[MQTT_INBOUND_MAX_TOPICS][MQTT_INBOUND_TOPIC_LENGTH];
+static volatile uint8_t inbound_topic_references[MQTT_INBOUND_MAX_TOPICS];
+
+static InboundAnnouncement inbound_pending[MQTT_INBOUND_MAX_PENDING];
+static volatile uint8_t inbound_pending_head  = 0;
+static volatile uint8_t inbound_pending_count = 0;
+static volatile uint32_t inbound_last_announcement_ms = 0;
+
+/**
+ * @brief Ring holding the fetched messages. Every message is stored as a
+ * header (see #INBOUND_HEADER_SIZE) followed by the payload.
+ */
+static uint8_t inbound_ring[MQTT_INBOUND_QUEUE_SIZE];
+static uint16_t inbound_ring_tail     = 0;
+static uint16_t inbound_ring_used     = 0;
+static uint8_t inbound_queued_messages = 0;
+
+/**
+ * @brief Where the next payload byte is placed whilst streaming a message into
+ * the ring, and how many bytes are left of the space reserved for it.
+ */
+static uint16_t inbound_stream_index     = 0;
+static uint16_t inbound_stream_remaining = 0;
+
+static uint16_t inboundRingIndex(const uint16_t index, const uint16_t offset) {
+    const uint16_t ring_index = index + offset;
+
+    return ring_index >= MQTT_INBOUND_QUEUE_SIZE
+               ? ring_index - MQTT_INBOUND_QUEUE_SIZE
+               : ring_index;
+}
+
+static void
+inboundRingWrite(const uint16_t index, const void* data, const uint16_t size) {
+    for (uint16_t i = 0; i < size; i++) {
+        inbound_ring[inboundRingIndex(index, i)] = ((const uint8_t*)data)[i];
+    }
+}
+
+static void
+inboundRingRead(const uint16_t index, void* data, const uint16_t size) {
+    for (uint16_t i = 0; i < size; i++) {
+        ((uint8_t*)data)[i] = inbound_ring[inboundRingIndex(index, i)];
+    }
+}
+
+static void inboundStreamSink(const uint8_t* chunk,
+                              const uint16_t chunk_length) {
+
+    // The announced message length is reserved in the ring, anything beyond
+    // that is discarded
+    const uint16_t length = min(chunk_length, inbound_stream_remaining);
+
+    inboundRingWrite(inbound_stream_index, chunk, length);
+
+    inbound_stream_index = inboundRingIndex(inbound_stream_index, length);
+    inbound_stream_remaining -= length;
+}
+
+/**
+ * @brief Releases a reference to an interned topic. Can be called outside of
+ * the ISR, so the update is done atomically.
+ */
+static void releaseInboundTopic(const uint8_t topic_index) {
+    cli();
+    inbound_topic_references[topic_index]--;
+    sei();
+}
+
+/**
+ * @brief Notes a message notified by the modem so that it can be fetched into
+ * the inbound queue later. Called from the receive URC callback (ISR).
+ *
+ * @return false if there is no space for the announcement or the topic, or
+ * the message would never fit in the ring, in which case the message has to be
+ * handled by the receive callbacks.
+ */
+static bool queueInboundAnnouncement(const char* topic,
+                                     const uint16_t message_length,
+                                     const int32_t message_id) {
+
+    // A message larger than the ring would block the announcements behind it
+    // forever, as fetchMessages() waits for space to fetch it
+    if (inbound_pending_count == MQTT_INBOUND_MAX_PENDING ||
+        strlen(topic) >= MQTT_INBOUND_TOPIC_LENGTH ||
+        (uint32_t)INBOUND_HEADER_SIZE + message_length >
+            MQTT_INBOUND_QUEUE_SIZE) {
+        return false;
+    }
+
+    int16_t topic_index = -1;
+
+    for (uint8_t i = 0; i < MQTT_INBOUND_MAX_TOPICS; i++) {
+        if (inbound_topic_references[i] == 0) {
+            if (topic_index < 0) {
+                topic_index = i;
+            }
+        } else if (strcmp(inbound_topics[i], topic) == 0) {
+            topic_index = i;
+            break;
+        }
+    }
+
+    if (topic_index < 0) {
+        return false;
+    }
+
+    if (inbound_topic_references[topic_index] == 0) {
+        strcpy(inbound_topics[topic_index], topic);
+    }
+
+    inbound_topic_references[topic_index]++;
+
+    InboundAnnouncement& announcement =
+        inbound_pending[(inbound_pending_head + inbound_pending_count) %
+                        MQTT_INBOUND_MAX_PENDING];
+
+    announcement.topic_index    = topic_index;
+    announcement.message_id     = message_id;
+    announcement.message_length = message_length;
+
+    inbound_pending_count++;
+    inbound_last_announcement_ms = millis();
+
+    return true;
+}
+
+/**
+ * @brief Discards all announcements not yet fetched into the inbound queue.
+ */
+static void clearInboundAnnouncements(void) {
+    cli();
+
+    while (inbound_pending_count > 0) {
+        inbound_topic_references[inbound_pending[inbound_pending_head]
+                                     .topic_index]--;
+
+        inbound_pending_head = (inbound_pending_head + 1) %
+                               MQTT_INBOUND_MAX_PENDING;
+        inbound_pending_count--;
+    }
+
+    sei();
+}
+
+static void internalDisconnectCallback(__attribute__((unused)) char* urc_data) {
+    connected_to_broker = false;
+    LedCtrl.off(Led::CON, true);
+
+    if (disconnected_callback != NULL) {
+        disconnected_callback();
+    }
+}
+
+/**
+ * @brief Entry in the QoS 2 delivery state table. Whether the message ID is
+ * for an incoming or outgoing message is given by the state.
+ */
+typedef struct {
+    uint16_t message_id;
+    MqttDeliveryState state;
+} DeliveryStateEntry;
+
+/**
+ * @brief The QoS 2 delivery state table, laid out as it is persisted in
+ * EEPROM. Entries are replaced in a round robin fashion.
+ */
+typedef struct {
+    uint8_t magic;
+    uint8_t next_index;
+    DeliveryStateEntry entries[MQTT_QOS2_STATE_TABLE_SIZE];
+} DeliveryStateTable;
+
+static_assert(sizeof(DeliveryStateTable) <= EEPROM_LAYOUT_MQTT_QOS2_SIZE,
+              "The delivery state table doesn't fit in its space in EEPROM");
+
+static DeliveryStateTable delivery_states   = {};
+static volatile bool delivery_states_dirty = false;
+static bool delivery_states_loaded         = false;
+
+/**
+ * @brief When the incoming messages in the table were read, from millis().
+ * Only kept in RAM, as the incoming entries don't outlive the connection.
+ */
+static uint32_t delivered_ms[MQTT_QOS2_STATE_TABLE_SIZE];
+
+/**
+ * @brief Redelivered QoS 2 messages which are waiting to be read out of the
+ * modem by MqttClientClass::poll() and thrown away.
+ */
+typedef struct {
+    uint16_t message_id;
+    char topic[MQTT_INBOUND_TOPIC_LENGTH];
+} PendingDiscard;
+
+static PendingDiscard pending_discards[MQTT_QOS2_MAX_PENDING_DISCARDS];
+static volatile uint8_t num_pending_discards = 0;
+
+static int32_t last_publish_message_id = -1;
+
+static bool isIncomingDeliveryState(const MqttDeliveryState state) {
+    return state == MqttDeliveryState::RECEIVED ||
+           state == MqttDeliveryState::DELIVERED;
+}
+
+/**
+ * @brief Finds the entry for @p message_id. Has to be called with interrupts
+ * disabled outside of the ISR.
+ *
+ * @param incoming Whether to look for an incoming or outgoing message.
+ *
+ * @return The entry or NULL if the message ID is not in the table.
+ */
+static DeliveryStateEntry* findDeliveryState(const uint16_t message_id,
+                                             const bool incoming) {
+
+    for (uint8_t i = 0; i < MQTT_QOS2_STATE_TABLE_SIZE; i++) {
+        DeliveryStateEntry* entry = &delivery_states.entries[i];
+
+        if (entry->state != MqttDeliveryState::UNKNOWN &&
+            entry->message_id == message_id &&
+            isIncomingDeliveryState(entry->state) == incoming) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Updates or inserts the entry for @p message_id. Has to be called
+ * with interrupts disabled outside of the ISR.
+ */
+static void setDeliveryState(const uint16_t message_id,
+                             const MqttDeliveryState state) {
+
+    DeliveryStateEntry* entry = findDeliveryState(
+        message_id,
+        isIncomingDeliveryState(state));
+
+    if (entry == NULL) {
+        entry = &delivery_states.entries[delivery_states.next_index];
+        entry->message_id = message_id;
+
+        delivery_states.next_index = (delivery_states.next_index + 1) %
+                                     MQTT_QOS2_STATE_TABLE_SIZE;
+    }
+
+    entry->state          = state;
+    delivery_states_dirty = true;
+}
+
+static void loadDeliveryStates(void) {
+
+    eeprom_read_block(&delivery_states,
+                      (const void*)MQTT_QOS2_EEPROM_ADDRESS,
+                      sizeof(delivery_states));
+
+    // Start from scratch if the EEPROM has not held the table before
+    if (delivery_states.magic != DELIVERY_STATE_TABLE_MAGIC ||
+        delivery_states.next_index >= MQTT_QOS2_STATE_TABLE_SIZE) {
+        memset(&delivery_states, 0, sizeof(delivery_states));
+        delivery_states.magic = DELIVERY_STATE_TABLE_MAGIC;
+    }
+
+    delivery_states_dirty  = false;
+    delivery_states_loaded = true;
+}
+
+/**
+ * @brief Writes the delivery state table to EEPROM if it has changed. Not to be
+ * called from the ISR, as the EEPROM writes are slow.
+ */
+static void persistDeliveryStates(void) {
+
+    if (!delivery_states_dirty) {
+        return;
+    }
+
+    cli();
+    const DeliveryStateTable table = delivery_states;
+    delivery_states_dirty          = false;
+    sei();
+
+    // Only the bytes which have changed are written, which limits the wear
+    eeprom_update_block(&table,
+                        (void*)MQTT_QOS2_EEPROM_ADDRESS,
+                        sizeof(table));
+}
+
+/**
+ * @brief Forgets the incoming message IDs. The broker numbers the messages of
+ * a new clean session from scratch, so they would otherwise suppress new
+ * messages which reuse the IDs.
+ */
+static void clearIncomingDeliveryStates(void) {
+
+    cli();
+
+    for (uint8_t i = 0; i < MQTT_QOS2_STATE_TABLE_SIZE; i++) {
+        DeliveryStateEntry* entry = &delivery_states.entries[i];
+
+        if (isIncomingDeliveryState(entry->state)) {
+            entry->state          = MqttDeliveryState::UNKNOWN;
+            delivery_states_dirty = true;
+        }
+    }
+
+    sei();
+
+    persistDeliveryStates();
+}
+
+/**
+ * @brief Tracks an incoming QoS 2 message announced by the modem. Called from
+ * the ISR.
+ *
+ * @return true if the message has already been delivered and should be
+ * discarded.
+ */
+static bool trackIncomingDelivery(const char* topic,
+                                  const uint8_t quality_of_service,
+                                  const uint16_t message_id) {
+
+    if (quality_of_service != EXACTLY_ONCE) {
+        return false;
+    }
+
+    const DeliveryStateEntry* entry = findDeliveryState(message_id, true);
+
+    // Once the broker has released the message ID with PUBREL, which the
+    // modem handles without reporting it, the ID may be reused for a new
+    // message
+    const bool is_redelivery =
+        entry != NULL && entry->state == MqttDeliveryState::DELIVERED &&
+        millis() - delivered_ms[entry - delivery_states.entries] <
+            MQTT_QOS2_PUBREL_TIMEOUT_MS;
+
+    if (!is_redelivery) {
+        setDeliveryState(message_id, MqttDeliveryState::RECEIVED);
+        return false;
+    }
+
+    // If there is no room for discarding it, the redelivery is left in the
+    // modem, which is harmless apart from the memory it occupies there
+    if (num_pending_discards < MQTT_QOS2_MAX_PENDING_DISCARDS &&
+        strlen(topic) < MQTT_INBOUND_TOPIC_LENGTH) {
+
+        PendingDiscard* discard = &pending_discards[num_pending_discards++];
+        discard->message_id     = message_id;
+        strcpy(discard->topic, topic);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Marks an incoming QoS 2 message as read by the application.
+ */
+static void markDelivered(const int32_t message_id) {
+
+    if (message_id < 0) {
+        return;
+    }
+
+    cli();
+
+    DeliveryStateEntry* entry = findDeliveryState(message_id, true);
+
+    if (entry != NULL) {
+        entry->state          = MqttDeliveryState::DELIVERED;
+        delivery_states_dirty = true;
+
+        delivered_ms[entry - delivery_states.entries] = millis();
+    }
+
+    sei();
+
+    persistDeliveryStates();
+}
+
+/**
+ * @brief A topic registered with MqttClientClass::registerTopic(). The topic
+ * either lives in flash or is interned in #registered_topic_pool.
+ */
+typedef struct {
+    const char* topic;
+    uint16_t hash;
+    uint8_t length;
+    bool is_flash_string;
+} RegisteredTopic;
+
+static RegisteredTopic registered_topics[MQTT_MAX_REGISTERED_TOPICS];
+static uint8_t num_registered_topics = 0;
+
+static char registered_topic_pool[MQTT_REGISTERED_TOPIC_POOL_SIZE];
+static uint16_t registered_topic_pool_length = 0;
+
+/**
+ * @brief FNV-1a hash of the topic folded to 16 bits, used to look up
+ * registered topics without comparing the strings of all of them.
+ */
+static uint16_t topicHash(const char* topic, const bool is_flash_string) {
+
+    uint32_t hash = 2166136261UL;
+
+    while (true) {
+        const char c = is_flash_string ? pgm_read_byte(topic) : *topic;
+
+        if (c == '\0') {
+            break;
+        }
+
+        hash = (hash ^ (uint8_t)c) * 16777619UL;
+        topic++;
+    }
+
+    return (uint16_t)(hash >> 16) ^ (uint16_t)hash;
+}
+
+/**
+ * @brief Compares two topics where each of them can either be in RAM or flash.
+ */
+static bool topicsEqual(const char* a,
+                        const bool a_is_flash_string,
+                        const char* b,
+                        const bool b_is_flash_string) {
+
+    while (true) {
+        const char a_char = a_is_flash_string ? pgm_read_byte(a) : *a;
+        const char b_char = b_is_flash_string ? pgm_read_byte(b) : *b;
+
+        if (a_char != b_char) {
+            return false;
+        }
+
+        if (a_char == '\0') {
+            return true;
+        }
+
+        a++;
+        b++;
+    }
+}
+
+/**
+ * @return The handle of the registered topic or -1 if it is not registered.
  */
-static char urc_buffer[URC_DATA_BUFFER_SIZE + 1];
+static int8_t findRegisteredTopic(const char* topic,
+                                  const bool is_flash_string) {
 
-static void (*disconnected_callback)(void)                = NULL;
-static void (*receive_callback)(const char* topic,
-                                const uint16_t message_length,
-                                const int32_t message_id) = NULL;
+    const uint16_t hash = topicHash(topic, is_flash_string);
 
-static void internalDisconnectCallback(__attribute__((unused)) char* urc_data) {
-    connected_to_broker = false;
-    LedCtrl.off(Led::CON, true);
+    for (uint8_t i = 0; i < num_registered_topics; i++) {
+        const RegisteredTopic* registered_topic = &registered_topics[i];
 
-    if (disconnected_callback != NULL) {
-        disconnected_callback();
+        if (registered_topic->hash != hash) {
+            continue;
+        }
+
+        // Compare the strings as well in case of a hash collision
+        const bool equal = topicsEqual(registered_topic->topic,
+                                       registered_topic->is_flash_string,
+                                       topic,
+                                       is_flash_string);
+
+        if (equal) {
+            return i;
+        }
     }
+
+    return -1;
 }
 
 static void internalOnReceiveCallback(char* urc_data) {
 
-    // The incoming urc_data is a buffer of maximum URC_DATA_BUFFER_SIZE (from
-    // the SequansController)
-    strncpy(urc_buffer, urc_data, URC_DATA_BUFFER_SIZE);
+    // A topic longer than MQTT_TOPIC_MAX_LENGTH would be cut off, so the
+    // message is dropped rather than passed on with the wrong topic
+    if (strlen(urc_data) > MQTT_URC_BUFFER_SIZE) {
+        return;
+    }
 
-    // Safe guard ourselves
-    urc_buffer[URC_DATA_BUFFER_SIZE] = '\0';
+    strcpy(urc_buffer, urc_data);
 
     const bool got_topic = SequansController.extractValueFromCommandResponse(
         urc_buffer,
@@ -171,14 +1192,110 @@ static void internalOnReceiveCallback(char* urc_data) {
     int32_t message_id = -1;
 
     if (got_message_id) {
-        message_id = (int32_t)atoi(message_id_buffer);
+        message_id = (int32_t)atol(message_id_buffer);
+
+        char quality_of_service_buffer[2];
+
+        const bool got_quality_of_service =
+            SequansController.extractValueFromCommandResponse(
+                urc_buffer,
+                3,
+                quality_of_service_buffer,
+                sizeof(quality_of_service_buffer),
+                0);
+
+        if (got_quality_of_service &&
+            trackIncomingDelivery(topic,
+                                  atoi(quality_of_service_buffer),
+                                  message_id)) {
+            return;
+        }
+    }
+
+    const uint16_t message_length = (uint16_t)atoi(message_length_buffer);
+
+    if (inbound_queue_enabled &&
+        queueInboundAnnouncement(topic, message_length, message_id)) {
+        return;
+    }
+
+    if (topicTrieDispatch(topic_trie_root,
+                          topic,
+                          topic,
+                          message_length,
+                          message_id)) {
+        return;
+    }
+
+    if (receive_topic_handle_callback != NULL) {
+        receive_topic_handle_callback(topic,
+                                      findRegisteredTopic(topic, false),
+                                      message_length,
+                                      message_id);
+    } else if (receive_callback != NULL) {
+        receive_callback(topic, message_length, message_id);
+    }
+}
+
+/**
+ * @brief Timing breakdown of the last connection, see
+ * MqttClientClass::getConnectTimings().
+ */
+static MqttConnectTimings connect_timings = {};
+static uint32_t connect_request_ms       = 0;
+static uint32_t signature_written_ms     = 0;
+
+/**
+ * @brief Finds the field at @p index in the comma separated URC @p data
+ * without copying it.
+ *
+ * @param length [out] Length of the field.
+ *
+ * @return Pointer to the start of the field or NULL if there are not enough
+ * fields.
+ */
+static const char*
+findUrcField(const char* data, const uint8_t index, uint8_t* length) {
+
+    for (uint8_t i = 0; i < index; i++) {
+        data = strchr(data, ',');
+
+        if (data == NULL) {
+            return NULL;
+        }
+
+        data++;
+    }
+
+    // The URC data starts after the colon, so skip the space following it
+    while (*data == ' ') { data++; }
+
+    const char* end = data;
+
+    while (*end != '\0' && *end != ',' && *end != '\r') { end++; }
+
+    *length = end - data;
+
+    return data;
+}
+
+/**
+ * @return The value of the hex character @p c or -1 if it is not a hex
+ * character.
+ */
+static int8_t hexNibble(const char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
     }
 
-    if (receive_callback != NULL) {
-        receive_callback(topic,
-                         (uint16_t)atoi(message_length_buffer),
-                         message_id);
+    // Fold to lower case
+    const char lower = c | 0x20;
+
+    if (lower >= 'a' && lower <= 'f') {
+        return lower - 'a' + 10;
     }
+
+    return -1;
 }
 
 /**
@@ -190,73 +1307,74 @@ static void internalOnReceiveCallback(char* urc_data) {
  */
 static bool generateSigningCommand(char* data, char* command_buffer) {
 
-    // Grab the ctx id
-    // +1 for null termination
-    char ctx_id_buffer[HCESIGN_CTX_ID_LENGTH + 1];
+    uint8_t ctx_id_length = 0;
+    const char* ctx_id    = findUrcField(data, 0, &ctx_id_length);
 
-    bool got_ctx_id = SequansController.extractValueFromCommandResponse(
-        data,
-        0,
-        ctx_id_buffer,
-        HCESIGN_CTX_ID_LENGTH + 1,
-        (char)NULL);
-
-    if (!got_ctx_id) {
+    if (ctx_id == NULL || ctx_id_length == 0 ||
+        ctx_id_length > HCESIGN_CTX_ID_LENGTH) {
         Log.error(F("Failed to generate signing command, no context ID!"));
         return false;
     }
 
     // Grab the digest, which will be 32 bytes, but appear as 64 hex
     // characters
-    char digest[HCESIGN_DIGEST_LENGTH + 1];
+    uint8_t digest_length = 0;
+    const char* digest    = findUrcField(data, 3, &digest_length);
 
-    bool got_digest = SequansController.extractValueFromCommandResponse(
-        data,
-        3,
-        digest,
-        HCESIGN_DIGEST_LENGTH + 1,
-        (char)NULL);
-
-    if (!got_digest) {
+    if (digest == NULL || digest_length != HCESIGN_DIGEST_LENGTH) {
         Log.error(F("Failed to generate signing command, no digest for signing "
                     "request!"));
         return false;
     }
 
-    // Convert digest to 32 bytes
+    // Convert hex representation in string to numerical values
     uint8_t message_to_sign[HCESIGN_DIGEST_LENGTH / 2];
-    char* position = digest;
 
-    // Convert hex representation in string to numerical hex values
     for (uint8_t i = 0; i < sizeof(message_to_sign); i++) {
-        sscanf(position, "%2hhx", &message_to_sign[i]);
-        position += 2;
+        const int8_t high = hexNibble(digest[i * 2]);
+        const int8_t low  = hexNibble(digest[i * 2 + 1]);
+
+        if (high < 0 || low < 0) {
+            Log.error(F("Failed to generate signing command, digest is not "
+                        "valid hex!"));
+            return false;
+        }
+
+        message_to_sign[i] = (high << 4) | low;
     }
 
     // Sign digest with ECC's primary private key
-    const ATCA_STATUS result = atcab_sign(0, message_to_sign, (uint8_t*)digest);
+    uint8_t signature[HCESIGN_DIGEST_LENGTH];
+
+    const uint32_t sign_start_ms = millis();
+    const ATCA_STATUS result     = atcab_sign(0, message_to_sign, signature);
+    connect_timings.ecc_sign_ms  = millis() - sign_start_ms;
 
     if (result != ATCA_SUCCESS) {
         Log.errorf(F("ECC signing failed, status code: %X\r\n"), result);
         return false;
     }
 
-    // Now we need to convert the byte array into a hex string in
-    // compact form
+    // Build the command directly in the command buffer, the signature is
+    // written as a hex string in compact form
     const char hex_conversion[] = "0123456789abcdef";
 
-    // +1 for NULL termination
-    char signature[HCESIGN_DIGEST_LENGTH * 2 + 1] = "";
+    strcpy_P(command_buffer, HCESIGN_PREFIX);
+    char* position = command_buffer + strlen(command_buffer);
 
-    // Prepare signature by converting to a hex string
-    for (uint8_t i = 0; i < sizeof(digest) - 1; i++) {
-        signature[i * 2]     = hex_conversion[(digest[i] >> 4) & 0x0F];
-        signature[i * 2 + 1] = hex_conversion[digest[i] & 0x0F];
+    memcpy(position, ctx_id, ctx_id_length);
+    position += ctx_id_length;
+
+    strcpy_P(position, HCESIGN_INFIX);
+    position += strlen(position);
+
+    for (uint8_t i = 0; i < sizeof(signature); i++) {
+        *position++ = hex_conversion[signature[i] >> 4];
+        *position++ = hex_conversion[signature[i] & 0x0F];
     }
 
-    // NULL terminate
-    signature[HCESIGN_DIGEST_LENGTH * 2] = 0;
-    sprintf_P(command_buffer, HCESIGN, atoi(ctx_id_buffer), signature);
+    *position++ = '"';
+    *position   = '\0';
 
     return true;
 }
@@ -373,20 +1491,318 @@ bool MqttClientClass::beginAzure(const uint16_t keep_alive) {
     // 24 comes from the format in the string below. Add +1 for NULL termination
     char username[sizeof(hostname) + 24 + sizeof(device_id) + 1] = "";
 
-    snprintf_P(username,
-               sizeof(username),
-               PSTR("%s/%s/api-version=2018-06-30"),
-               hostname,
-               device_id);
+    snprintf_P(username,
+               sizeof(username),
+               PSTR("%s/%s/api-version=2018-06-30"),
+               hostname,
+               device_id);
+
+    return this->begin(device_id,
+                       hostname,
+                       8883,
+                       true,
+                       keep_alive,
+                       true,
+                       username,
+                       "");
+}
+
+/**
+ * @brief Terminates any existing connection and configures the MQTT client in
+ * the modem.
+ *
+ * @return true if the configuration was successful.
+ */
+static bool configureClient(const char* client_id,
+                            const bool use_tls,
+                            const bool use_ecc,
+                            const char* username,
+                            const char* password) {
+
+    // Disconnect to terminate existing configuration
+    //
+    // We do this with writeString instead of writeCommand to not issue the
+    // retries of the command if it fails.
+    SequansController.writeString(FV(MQTT_DISCONNECT), true);
+
+    // Force to read the result so that we don't go on with the next command
+    // instantly. We just want to close the current connection if there are any.
+    // If there aren't, this will return an error from the modem, but that is
+    // fine as it just means that there aren't any connections active.
+    SequansController.readResponse();
+
+    // The sequans modem fails if we specify 0 as TLS, so we just have to have
+    // two commands for this
+    if (use_tls) {
+
+        if (!SecurityProfile.profileExists(
+                use_ecc ? MQTT_TLS_ECC_SECURITY_PROFILE_ID
+                        : MQTT_TLS_SECURITY_PROFILE_ID)) {
+            Log.error(F("Security profile not set up for MQTT TLS. "
+                        "Run the 'provision' example Arduino sketch for more "
+                        "instructions on how to set this up."));
+            return false;
+        }
+
+        if (use_ecc) {
+
+            const ATCA_STATUS status = ECC608.begin();
+
+            if (status != ATCA_SUCCESS) {
+                Log.errorf(
+                    F("Could not initialize ECC hardware, error code: %X\r\n"),
+                    status);
+                return false;
+            }
+        }
+
+        const ResponseResult configure_response =
+            SequansController.writeCommand(
+                F("AT+SQNSMQTTCFG=0,\"%s\",\"%s\",\"%s\",%u"),
+                NULL,
+                0,
+                client_id,
+                username,
+                password,
+                use_ecc ? MQTT_TLS_ECC_SECURITY_PROFILE_ID
+                        : MQTT_TLS_SECURITY_PROFILE_ID);
+
+        if (configure_response != ResponseResult::OK) {
+            Log.errorf(
+                F("Failed to configure MQTT. The TLS setup might be incorrect. "
+                  "If you're using a custom broker with TLS, run the provision "
+                  "example sketch in order to provision for a custom MQTT "
+                  "broker "
+                  "with TLS. Error code: %X\r\n"),
+                static_cast<uint8_t>(configure_response));
+
+            return false;
+        }
+    } else {
+
+        const ResponseResult configure_response =
+            SequansController.writeCommand(
+                F("AT+SQNSMQTTCFG=0,\"%s\",\"%s\",\"%s\""),
+                NULL,
+                0,
+                client_id,
+                username,
+                password);
+
+        if (configure_response != ResponseResult::OK) {
+            Log.errorf(F("Failed to configure MQTT, error code: %X\r\n"),
+                       static_cast<uint8_t>(configure_response));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Whether the keep-alive is derived from the power save mode period,
+ * see MqttClientClass::enableAdaptiveKeepAlive().
+ */
+static bool adaptive_keep_alive_enabled = false;
+
+/**
+ * @brief The keep-alive used for the current (or last) connection.
+ */
+static uint16_t connection_keep_alive = 0;
+
+/**
+ * @return The keep-alive to use for a connection. If adaptive keep-alive is
+ * enabled and power save mode is configured, it is the period granted by the
+ * operator plus a margin, so that the broker doesn't drop the connection
+ * whilst the modem sleeps. Otherwise @p keep_alive.
+ */
+static uint16_t effectiveKeepAlive(const uint16_t keep_alive) {
+
+    if (!adaptive_keep_alive_enabled) {
+        return keep_alive;
+    }
+
+    const uint32_t period = LowPower.getPowerSaveModePeriod();
+
+    if (period == 0) {
+        return keep_alive;
+    }
+
+    return min(period + MQTT_PSM_KEEP_ALIVE_MARGIN_S, (uint32_t)UINT16_MAX);
+}
+
+/**
+ * @brief Requests a connection to the broker. The result is reported with the
+ * SQNSMQTTONCONNECT URC.
+ */
+static bool requestConnection(const char* host,
+                              const uint16_t port,
+                              const uint16_t keep_alive) {
+
+    connection_keep_alive = keep_alive;
+
+    clearIncomingDeliveryStates();
+
+    memset(&connect_timings, 0, sizeof(connect_timings));
+    connect_request_ms   = millis();
+    signature_written_ms = connect_request_ms;
+
+    const ResponseResult connect_response = SequansController.writeCommand(
+        F("AT+SQNSMQTTCONNECT=0,\"%s\",%u,%u"),
+        NULL,
+        0,
+        host,
+        port,
+        keep_alive);
+
+    if (connect_response != ResponseResult::OK) {
+        Log.errorf(F("Failed to request connection to MQTT broker, error code: "
+                     "%X\r\n"),
+                   static_cast<uint8_t>(connect_response));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Signs the digest in the signing request URC @p data with the ECC and
+ * passes the signature to the modem.
+ */
+static bool handleSigningRequest(char* data) {
+
+    char signing_request_buffer[MQTT_SIGNING_BUFFER + 1] = "";
+
+    connect_timings.modem_tls_ms = millis() - connect_request_ms;
+
+    SequansController.startCriticalSection();
+
+    if (!generateSigningCommand(data, signing_request_buffer)) {
+        SequansController.stopCriticalSection();
+        return false;
+    }
+
+    const uint32_t write_start_ms = millis();
+    SequansController.writeString(signing_request_buffer, true);
+    signature_written_ms = millis();
+
+    SequansController.stopCriticalSection();
+
+    connect_timings.uart_write_ms = signature_written_ms - write_start_ms;
+
+    return true;
+}
+
+/**
+ * @brief Records the end of the connection timing breakdown when the connect
+ * response arrives.
+ */
+static void recordConnectResponse(void) {
+    const uint32_t now_ms     = millis();
+    connect_timings.broker_ms = now_ms - signature_written_ms;
+    connect_timings.total_ms  = now_ms - connect_request_ms;
+}
+
+/**
+ * @brief Extracts the status code from the SQNSMQTTONCONNECT URC.
+ *
+ * @return The status code (see #STATUS_CODE_TABLE) or -1 if the status code
+ * could not be extracted.
+ */
+static int8_t extractConnectionStatusCode(char* urc_data) {
+
+    // At most we can have two character ("-x"). We add an extra for null
+    // termination
+    char status_code_buffer[3] = "";
+
+    if (!SequansController.extractValueFromCommandResponse(
+            urc_data,
+            MQTT_URC_STATUS_CODE_INDEX,
+            status_code_buffer,
+            sizeof(status_code_buffer),
+            (char)NULL)) {
+        return -1;
+    }
+
+    // Status codes are reported as negative numbers, so we need to take the
+    // absolute value. 0 is success.
+    const uint8_t status_code = abs(atoi(status_code_buffer));
+
+    return status_code < NUM_STATUS_CODES ? status_code
+                                          : STATUS_CODE_INVALID_VALUE;
+}
+
+/**
+ * @brief Sets up the state for a new connection to the broker.
+ */
+static void onConnectedToBroker(void) {
+
+    connected_to_broker = true;
+    LedCtrl.on(Led::CON, true);
+
+    Log.debugf(F("MQTT connect took %lu ms (modem TLS: %lu ms, ECC sign: %lu "
+                 "ms, UART: %lu ms, broker: %lu ms)\r\n"),
+               connect_timings.total_ms,
+               connect_timings.modem_tls_ms,
+               connect_timings.ecc_sign_ms,
+               connect_timings.uart_write_ms,
+               connect_timings.broker_ms);
+
+    SequansController.registerCallback(FV(MQTT_ON_DISCONNECT_URC),
+                                       internalDisconnectCallback);
+
+    // The receive callback is unregistered when the connection ends, so
+    // re-register it if anyone is listening for messages
+    if (receive_callback != NULL || receive_topic_handle_callback != NULL ||
+        topic_trie_root != TOPIC_TRIE_NO_NODE || inbound_queue_enabled) {
+        SequansController.registerCallback(FV(MQTT_ON_MESSAGE_URC),
+                                           internalOnReceiveCallback);
+    }
+}
+
+static void unregisterReconnectCallbacks(void) {
+    SequansController.unregisterCallback(FV(MQTT_SIGN_URC));
+    SequansController.unregisterCallback(FV(MQTT_ON_CONNECT_URC));
+}
+
+/**
+ * @brief Remembers the configuration of the last call to
+ * MqttClientClass::begin() so that the reconnect engine can re-use it. The
+ * strings are packed in #reconnect_config_pool.
+ */
+static void rememberConfiguration(const char* client_id,
+                                  const char* host,
+                                  const uint16_t port,
+                                  const bool use_tls,
+                                  const uint16_t keep_alive,
+                                  const bool use_ecc,
+                                  const char* username,
+                                  const char* password) {
+
+    const char* strings[] = {client_id, host, username, password};
+    uint16_t offset       = 0;
+
+    reconnect_config.valid = false;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        const size_t size = strlen(strings[i]) + 1;
+
+        if (offset + size > MQTT_RECONNECT_CONFIG_POOL_SIZE) {
+            Log.warn(F("MQTT configuration too large to be remembered, "
+                       "automatic reconnect is not available"));
+            return;
+        }
+
+        memcpy(&reconnect_config_pool[offset], strings[i], size);
+        reconnect_config.offsets[i] = offset;
+        offset += size;
+    }
 
-    return this->begin(device_id,
-                       hostname,
-                       8883,
-                       true,
-                       keep_alive,
-                       true,
-                       username,
-                       "");
+    reconnect_config.port       = port;
+    reconnect_config.keep_alive = keep_alive;
+    reconnect_config.use_tls    = use_tls;
+    reconnect_config.use_ecc    = use_ecc;
+    reconnect_config.valid      = true;
 }
 
 bool MqttClientClass::begin(const char* client_id,
@@ -406,99 +1822,39 @@ bool MqttClientClass::begin(const char* client_id,
 
     connected_to_broker = false;
 
-    // Disconnect to terminate existing configuration
-    //
-    // We do this with writeString instead of writeCommand to not issue the
-    // retries of the command if it fails.
-    SequansController.writeString(FV(MQTT_DISCONNECT), true);
-
-    // Force to read the result so that we don't go on with the next command
-    // instantly. We just want to close the current connection if there are any.
-    // If there aren't, this will return an error from the modem, but that is
-    // fine as it just means that there aren't any connections active.
-    SequansController.readResponse();
-
-    // -- Configuration --
-
-    // The sequans modem fails if we specify 0 as TLS, so we just have to have
-    // two commands for this
-    if (use_tls) {
-
-        if (!SecurityProfile.profileExists(
-                use_ecc ? MQTT_TLS_ECC_SECURITY_PROFILE_ID
-                        : MQTT_TLS_SECURITY_PROFILE_ID)) {
-            Log.error(F("Security profile not set up for MQTT TLS. "
-                        "Run the 'provision' example Arduino sketch for more "
-                        "instructions on how to set this up."));
-            return false;
-        }
-
-        if (use_ecc) {
-
-            const ATCA_STATUS status = ECC608.begin();
-
-            if (status != ATCA_SUCCESS) {
-                Log.errorf(
-                    F("Could not initialize ECC hardware, error code: %X\r\n"),
-                    status);
-                return false;
-            }
-        }
+    if (!delivery_states_loaded) {
+        loadDeliveryStates();
+    }
 
-        const ResponseResult configure_response =
-            SequansController.writeCommand(
-                F("AT+SQNSMQTTCFG=0,\"%s\",\"%s\",\"%s\",%u"),
-                NULL,
-                0,
-                client_id,
-                username,
-                password,
-                use_ecc ? MQTT_TLS_ECC_SECURITY_PROFILE_ID
-                        : MQTT_TLS_SECURITY_PROFILE_ID);
+    // An explicit begin takes over from the reconnect engine, which will pick
+    // up the state of the connection at the next poll. The URCs of a reconnect
+    // attempt in flight are no longer of interest
+    if (reconnect_state == ReconnectState::CONNECTING) {
+        unregisterReconnectCallbacks();
+    } else if (reconnect_state == ReconnectState::REPLAYING_SUBSCRIPTIONS) {
+        SequansController.unregisterCallback(FV(MQTT_ON_SUBSCRIBE_URC));
+    }
 
-        if (configure_response != ResponseResult::OK) {
-            Log.errorf(
-                F("Failed to configure MQTT. The TLS setup might be incorrect. "
-                  "If you're using a custom broker with TLS, run the provision "
-                  "example sketch in order to provision for a custom MQTT "
-                  "broker "
-                  "with TLS. Error code: %X\r\n"),
-                static_cast<uint8_t>(configure_response));
+    reconnect_state = ReconnectState::IDLE;
 
-            return false;
-        }
-    } else {
+    rememberConfiguration(client_id,
+                          host,
+                          port,
+                          use_tls,
+                          keep_alive,
+                          use_ecc,
+                          username,
+                          password);
 
-        const ResponseResult configure_response =
-            SequansController.writeCommand(
-                F("AT+SQNSMQTTCFG=0,\"%s\",\"%s\",\"%s\""),
-                NULL,
-                0,
-                client_id,
-                username,
-                password);
+    // -- Configuration --
 
-        if (configure_response != ResponseResult::OK) {
-            Log.errorf(F("Failed to configure MQTT, error code: %X\r\n"),
-                       static_cast<uint8_t>(configure_response));
-            return false;
-        }
+    if (!configureClient(client_id, use_tls, use_ecc, username, password)) {
+        return false;
     }
 
     // -- Request connection --
 
-    const ResponseResult connect_response = SequansController.writeCommand(
-        F("AT+SQNSMQTTCONNECT=0,\"%s\",%u,%u"),
-        NULL,
-        0,
-        host,
-        port,
-        keep_alive);
-
-    if (connect_response != ResponseResult::OK) {
-        Log.errorf(F("Failed to request connection to MQTT broker, error code: "
-                     "%X\r\n"),
-                   static_cast<uint8_t>(connect_response));
+    if (!requestConnection(host, port, effectiveKeepAlive(keep_alive))) {
         return false;
     }
 
@@ -519,9 +1875,9 @@ bool MqttClientClass::begin(const char* client_id,
 
         // Need to wait for a sign URC if we are using the ECC
         const bool got_sign_urc = SequansController.waitForURC(
-            F("SQNHCESIGN"),
+            FV(MQTT_SIGN_URC),
             urc_buffer,
-            sizeof(urc_buffer),
+            MQTT_URC_BUFFER_SIZE,
             timeout_ms,
             print_messages ? toggle_led_with_printing : toggle_led,
             500);
@@ -544,14 +1900,7 @@ bool MqttClientClass::begin(const char* client_id,
             return false;
         }
 
-        char signing_request_buffer[MQTT_SIGNING_BUFFER + 1] = "";
-
-        SequansController.startCriticalSection();
-        const bool success = generateSigningCommand(urc_buffer,
-                                                    signing_request_buffer);
-
-        if (!success) {
-            SequansController.stopCriticalSection();
+        if (!handleSigningRequest(urc_buffer)) {
 
             const char* error_message = PSTR(
                 "Unable to handle signature request\r\n");
@@ -565,20 +1914,19 @@ bool MqttClientClass::begin(const char* client_id,
             LedCtrl.off(Led::CON, true);
             return false;
         }
-
-        SequansController.writeString(signing_request_buffer, true);
-        SequansController.stopCriticalSection();
     }
 
     // Wait for connection response
     const bool got_connect_urc = SequansController.waitForURC(
-        F("SQNSMQTTONCONNECT"),
+        FV(MQTT_ON_CONNECT_URC),
         urc_buffer,
-        sizeof(urc_buffer),
+        MQTT_URC_BUFFER_SIZE,
         timeout_ms,
         print_messages ? toggle_led_with_printing : toggle_led,
         500);
 
+    recordConnectResponse();
+
     if (!got_connect_urc) {
         const char* error_message = PSTR(
             "Timed out waiting for connection response.\r\n");
@@ -593,16 +1941,10 @@ bool MqttClientClass::begin(const char* client_id,
         return false;
     }
 
-    // At most we can have two character ("-x"). We add an extra for null
-    // termination
-    char status_code_buffer[3] = "";
+    const int8_t connection_response_code = extractConnectionStatusCode(
+        urc_buffer);
 
-    if (!SequansController.extractValueFromCommandResponse(
-            urc_buffer,
-            MQTT_URC_STATUS_CODE_INDEX,
-            status_code_buffer,
-            sizeof(status_code_buffer),
-            (char)NULL)) {
+    if (connection_response_code < 0) {
 
         const char* error_message = PSTR(
             "Failed to extract status code for connection.\r\n");
@@ -617,21 +1959,17 @@ bool MqttClientClass::begin(const char* client_id,
         return false;
     }
 
-    // Status codes are reported as negative numbers, so we need to take the
-    // absolute value. 0 is success.
-    const uint8_t connection_response_code = abs(atoi(status_code_buffer));
-
     if (!connection_response_code) {
 
         if (print_messages) {
             Log.raw(F(" OK!"));
         }
 
-        connected_to_broker = true;
-        LedCtrl.on(Led::CON, true);
+        onConnectedToBroker();
 
-        SequansController.registerCallback(FV(MQTT_ON_DISCONNECT_URC),
-                                           internalDisconnectCallback);
+        if (num_subscriptions > 0 && !replaySubscriptions()) {
+            Log.warn(F("Not all previous subscriptions could be replayed"));
+        }
     } else {
 
         if (print_messages) {
@@ -651,6 +1989,181 @@ bool MqttClientClass::begin(const char* client_id,
     return connected_to_broker;
 }
 
+static void reconnectSignRequestCallback(char* urc_data) {
+
+    // The signing is done outside of the ISR in MqttClientClass::poll()
+    strncpy(urc_buffer, urc_data, MQTT_URC_BUFFER_SIZE);
+    urc_buffer[MQTT_URC_BUFFER_SIZE] = '\0';
+
+    reconnect_got_sign_request = true;
+}
+
+static void reconnectConnectCallback(char* urc_data) {
+    recordConnectResponse();
+    reconnect_connect_status       = extractConnectionStatusCode(urc_data);
+    reconnect_got_connect_response = true;
+}
+
+/**
+ * @brief Schedules the next reconnect attempt with exponential backoff. Half
+ * of the backoff is random, so that a fleet of devices losing the connection
+ * at the same time don't reconnect at the same time.
+ */
+static void scheduleReconnect(void) {
+
+    if (!reconnect_random_seeded) {
+
+        // The client ID is unique for the device, so it is used to make the
+        // random sequence differ between devices
+        uint32_t seed = micros();
+
+        const char* client_id =
+            &reconnect_config_pool[reconnect_config.offsets[0]];
+
+        for (const char* c = client_id; *c != '\0'; c++) {
+            seed = (seed ^ (uint8_t)*c) * 16777619UL;
+        }
+
+        randomSeed(seed);
+        reconnect_random_seeded = true;
+    }
+
+    const uint8_t shift = min(reconnect_attempt,
+                              MQTT_RECONNECT_MAX_BACKOFF_SHIFT);
+
+    uint32_t backoff_ms = reconnect_min_backoff_ms << shift;
+
+    // Guard against overflow of the shift as well
+    if (backoff_ms > reconnect_max_backoff_ms ||
+        (backoff_ms >> shift) != reconnect_min_backoff_ms) {
+        backoff_ms = reconnect_max_backoff_ms;
+    }
+
+    reconnect_backoff_ms = backoff_ms / 2 + random(backoff_ms / 2 + 1);
+    reconnect_backoff_start_ms = millis();
+
+    if (reconnect_attempt < UINT8_MAX) {
+        reconnect_attempt++;
+    }
+
+    reconnect_state = ReconnectState::BACKING_OFF;
+
+    Log.debugf(F("Reconnecting to MQTT broker in %lu ms\r\n"),
+               reconnect_backoff_ms);
+}
+
+/**
+ * @brief Configures the client with the remembered configuration and requests
+ * a connection without waiting for the result.
+ */
+static void startReconnectAttempt(void) {
+
+    const char* client_id = &reconnect_config_pool[reconnect_config.offsets[0]];
+    const char* host      = &reconnect_config_pool[reconnect_config.offsets[1]];
+    const char* username  = &reconnect_config_pool[reconnect_config.offsets[2]];
+    const char* password  = &reconnect_config_pool[reconnect_config.offsets[3]];
+
+    reconnect_statistics.attempts++;
+    reconnect_attempt_start_ms = millis();
+
+    if (!configureClient(client_id,
+                         reconnect_config.use_tls,
+                         reconnect_config.use_ecc,
+                         username,
+                         password)) {
+        scheduleReconnect();
+        return;
+    }
+
+    reconnect_got_sign_request     = false;
+    reconnect_got_connect_response = false;
+
+    if (reconnect_config.use_tls && reconnect_config.use_ecc) {
+        SequansController.registerCallback(FV(MQTT_SIGN_URC),
+                                           reconnectSignRequestCallback);
+    }
+
+    SequansController.registerCallback(FV(MQTT_ON_CONNECT_URC),
+                                       reconnectConnectCallback);
+
+    if (!requestConnection(host,
+                           reconnect_config.port,
+                           effectiveKeepAlive(reconnect_config.keep_alive))) {
+        unregisterReconnectCallbacks();
+        scheduleReconnect();
+        return;
+    }
+
+    reconnect_state = ReconnectState::CONNECTING;
+}
+
+/**
+ * @brief Checks the progress of an ongoing reconnect attempt.
+ */
+static void updateReconnectAttempt(void) {
+
+    if (reconnect_got_sign_request) {
+        reconnect_got_sign_request = false;
+
+        if (!handleSigningRequest(urc_buffer)) {
+            Log.error(F("Unable to handle signature request whilst "
+                        "reconnecting"));
+            unregisterReconnectCallbacks();
+            scheduleReconnect();
+        }
+
+        return;
+    }
+
+    if (!reconnect_got_connect_response) {
+        if (millis() - reconnect_attempt_start_ms >
+            MQTT_RECONNECT_ATTEMPT_TIMEOUT_MS) {
+            Log.warn(F("Timed out whilst reconnecting to MQTT broker"));
+            unregisterReconnectCallbacks();
+            scheduleReconnect();
+        }
+
+        return;
+    }
+
+    unregisterReconnectCallbacks();
+
+    if (reconnect_connect_status != 0) {
+        Log.warnf(F("Unable to reconnect to broker: %S.\r\n"),
+                  reconnect_connect_status < 0
+                      ? PSTR("No status code")
+                      : (PGM_P)pgm_read_word_far(
+                            &(STATUS_CODE_TABLE[reconnect_connect_status])));
+        scheduleReconnect();
+        return;
+    }
+
+    onConnectedToBroker();
+
+    const uint32_t now_ms = millis();
+
+    reconnect_statistics.reconnects++;
+    reconnect_statistics.last_connect_duration_ms = now_ms -
+                                                    reconnect_attempt_start_ms;
+    reconnect_statistics.last_outage_ms = now_ms - connection_lost_ms;
+    reconnect_statistics.longest_outage_ms = max(
+        reconnect_statistics.longest_outage_ms,
+        reconnect_statistics.last_outage_ms);
+
+    Log.infof(F("Reconnected to MQTT broker after %lu ms\r\n"),
+              reconnect_statistics.last_outage_ms);
+
+    reconnect_attempt = 0;
+
+    // The confirmations of the subscriptions are collected by poll()
+    if (num_subscriptions > 0) {
+        requestSubscriptionReplay();
+        reconnect_state = ReconnectState::REPLAYING_SUBSCRIPTIONS;
+    } else {
+        reconnect_state = ReconnectState::CONNECTED;
+    }
+}
+
 bool MqttClientClass::end() {
 
     LedCtrl.off(Led::CON, true);
@@ -665,6 +2178,9 @@ bool MqttClientClass::end() {
 
     connected_to_broker = false;
 
+    // The messages are not retrievable from the modem after a disconnect
+    clearInboundAnnouncements();
+
     if (disconnected_callback != NULL) {
         disconnected_callback();
     }
@@ -672,6 +2188,183 @@ bool MqttClientClass::end() {
     return true;
 }
 
+void MqttClientClass::enableAutoReconnect(const uint32_t min_backoff_ms,
+                                          const uint32_t max_backoff_ms) {
+    reconnect_min_backoff_ms = max(min_backoff_ms, 1UL);
+    reconnect_max_backoff_ms = max(max_backoff_ms, reconnect_min_backoff_ms);
+    reconnect_enabled        = true;
+    reconnect_attempt        = 0;
+    reconnect_state          = ReconnectState::IDLE;
+}
+
+void MqttClientClass::disableAutoReconnect(void) {
+
+    if (reconnect_state == ReconnectState::CONNECTING) {
+        unregisterReconnectCallbacks();
+    } else if (reconnect_state == ReconnectState::REPLAYING_SUBSCRIPTIONS) {
+        SequansController.unregisterCallback(FV(MQTT_ON_SUBSCRIBE_URC));
+    }
+
+    reconnect_enabled = false;
+    reconnect_state   = ReconnectState::IDLE;
+}
+
+bool MqttClientClass::poll(void) {
+
+    while (num_pending_discards > 0) {
+
+        cli();
+        const PendingDiscard discard = pending_discards[--num_pending_discards];
+        sei();
+
+        Log.debugf(F("Discarding redelivered message with ID %u on %s\r\n"),
+                   discard.message_id,
+                   discard.topic);
+
+        streamMessage(
+            discard.topic,
+            [](const uint8_t*, const uint16_t) {},
+            NULL,
+            discard.message_id);
+    }
+
+    persistDeliveryStates();
+
+    // The keep-alive can only be changed when connecting, so reconnect if the
+    // power save mode period has changed since the connection was made. The
+    // period is cached by LowPower, which also limits how often a failed
+    // retrieval is retried, so this doesn't query the modem on every poll
+    if (reconnect_enabled && reconnect_state == ReconnectState::CONNECTED &&
+        connected_to_broker && adaptive_keep_alive_enabled) {
+
+        const uint16_t keep_alive = effectiveKeepAlive(connection_keep_alive);
+
+        if (keep_alive != connection_keep_alive) {
+            Log.infof(F("Power save mode period changed, reconnecting with "
+                        "keep-alive of %u seconds\r\n"),
+                      keep_alive);
+            end();
+        }
+    }
+
+    if (!reconnect_enabled) {
+        return connected_to_broker;
+    }
+
+    switch (reconnect_state) {
+
+    case ReconnectState::IDLE:
+
+        if (connected_to_broker) {
+            reconnect_state = ReconnectState::CONNECTED;
+        } else if (reconnect_config.valid) {
+            connection_lost_ms = millis();
+            scheduleReconnect();
+        }
+
+        break;
+
+    case ReconnectState::CONNECTED:
+
+        if (!connected_to_broker) {
+            connection_lost_ms = millis();
+            reconnect_attempt  = 0;
+            scheduleReconnect();
+        }
+
+        break;
+
+    case ReconnectState::BACKING_OFF:
+
+        if (millis() - reconnect_backoff_start_ms < reconnect_backoff_ms) {
+            break;
+        }
+
+        if (!Lte.isConnected()) {
+            scheduleReconnect();
+            break;
+        }
+
+        startReconnectAttempt();
+        break;
+
+    case ReconnectState::CONNECTING:
+        updateReconnectAttempt();
+        break;
+
+    case ReconnectState::REPLAYING_SUBSCRIPTIONS:
+
+        if (!connected_to_broker) {
+            SequansController.unregisterCallback(FV(MQTT_ON_SUBSCRIBE_URC));
+
+            connection_lost_ms = millis();
+            reconnect_attempt  = 0;
+            scheduleReconnect();
+        } else if (isSubscriptionReplayDone()) {
+            if (!finishSubscriptionReplay()) {
+                Log.warn(F("Not all previous subscriptions could be "
+                           "replayed"));
+            }
+
+            reconnect_state = ReconnectState::CONNECTED;
+        }
+
+        break;
+    }
+
+    return connected_to_broker;
+}
+
+MqttReconnectStatistics MqttClientClass::getReconnectStatistics(void) {
+    return reconnect_statistics;
+}
+
+MqttConnectTimings MqttClientClass::getConnectTimings(void) {
+    return connect_timings;
+}
+
+void MqttClientClass::enableAdaptiveKeepAlive(const bool enable) {
+    adaptive_keep_alive_enabled = enable;
+}
+
+uint16_t MqttClientClass::getKeepAlive(void) { return connection_keep_alive; }
+
+int32_t MqttClientClass::getLastPublishMessageId(void) {
+    return last_publish_message_id;
+}
+
+MqttDeliveryState MqttClientClass::getPublishState(const uint16_t message_id) {
+    cli();
+    const DeliveryStateEntry* entry = findDeliveryState(message_id, false);
+    const MqttDeliveryState state   = entry == NULL ? MqttDeliveryState::UNKNOWN
+                                                    : entry->state;
+    sei();
+
+    return state;
+}
+
+MqttDeliveryState MqttClientClass::getReceiveState(const uint16_t message_id) {
+    cli();
+    const DeliveryStateEntry* entry = findDeliveryState(message_id, true);
+    const MqttDeliveryState state   = entry == NULL ? MqttDeliveryState::UNKNOWN
+                                                    : entry->state;
+    sei();
+
+    return state;
+}
+
+void MqttClientClass::clearDeliveryStates(void) {
+    cli();
+    memset(&delivery_states, 0, sizeof(delivery_states));
+    delivery_states.magic  = DELIVERY_STATE_TABLE_MAGIC;
+    delivery_states_dirty  = true;
+    delivery_states_loaded = true;
+    num_pending_discards   = 0;
+    sei();
+
+    persistDeliveryStates();
+}
+
 void MqttClientClass::onConnectionStatusChange(
     __attribute__((unused)) void (*connected)(void),
     void (*disconnected)(void)) {
@@ -689,25 +2382,56 @@ void MqttClientClass::onDisconnect(void (*disconnected)(void)) {
 
 bool MqttClientClass::isConnected() { return connected_to_broker; }
 
-bool MqttClientClass::publish(const char* topic,
-                              const uint8_t* buffer,
-                              const uint32_t buffer_size,
-                              const MqttQoS quality_of_service,
-                              const uint32_t timeout_ms) {
+static int8_t internTopic(const char* topic, const bool is_flash_string) {
 
-    if (!isConnected()) {
-        Log.error(F("Attempted publish without being connected to a broker"));
-        LedCtrl.off(Led::DATA, false);
-        return false;
+    const int8_t existing_handle = findRegisteredTopic(topic, is_flash_string);
+
+    if (existing_handle >= 0) {
+        return existing_handle;
     }
 
-    LedCtrl.on(Led::DATA, true);
+    const size_t length = is_flash_string ? strlen_P(topic) : strlen(topic);
 
-    SequansController.writeString(F("AT+SQNSMQTTPUBLISH=0,\"%s\",%u,%lu"),
-                                  true,
-                                  topic,
-                                  quality_of_service,
-                                  buffer_size);
+    if (length == 0 || length > MQTT_TOPIC_MAX_LENGTH ||
+        length > UINT8_MAX ||
+        num_registered_topics == MQTT_MAX_REGISTERED_TOPICS) {
+        return -1;
+    }
+
+    RegisteredTopic* registered_topic =
+        &registered_topics[num_registered_topics];
+
+    if (is_flash_string) {
+        registered_topic->topic = topic;
+    } else {
+        if (registered_topic_pool_length + length + 1 >
+            MQTT_REGISTERED_TOPIC_POOL_SIZE) {
+            return -1;
+        }
+
+        char* interned_topic =
+            &registered_topic_pool[registered_topic_pool_length];
+        memcpy(interned_topic, topic, length + 1);
+        registered_topic_pool_length += length + 1;
+
+        registered_topic->topic = interned_topic;
+    }
+
+    registered_topic->hash            = topicHash(topic, is_flash_string);
+    registered_topic->length          = length;
+    registered_topic->is_flash_string = is_flash_string;
+
+    return num_registered_topics++;
+}
+
+/**
+ * @brief Delivers the payload of a publish after the publish command has been
+ * written and waits for the confirmation.
+ */
+static bool deliverPublishPayload(const uint8_t* buffer,
+                                  const uint32_t buffer_size,
+                                  const MqttQoS quality_of_service,
+                                  const uint32_t timeout_ms) {
 
     // Wait for start character for delivering payload
     if (!SequansController.waitForByte('>', MQTT_TIMEOUT_MS)) {
@@ -759,6 +2483,29 @@ bool MqttClientClass::publish(const char* topic,
 
     LedCtrl.off(Led::DATA, true);
 
+    char message_id_buffer[8] = "";
+
+    if (SequansController.extractValueFromCommandResponse(
+            urc,
+            MQTT_URC_MESSAGE_ID_INDEX,
+            message_id_buffer,
+            sizeof(message_id_buffer),
+            (char)NULL)) {
+
+        last_publish_message_id = atol(message_id_buffer);
+
+        if (quality_of_service == EXACTLY_ONCE) {
+            cli();
+            setDeliveryState(last_publish_message_id,
+                             publish_status_code == 0
+                                 ? MqttDeliveryState::PUBLISHED
+                                 : MqttDeliveryState::PUBLISH_FAILED);
+            sei();
+
+            persistDeliveryStates();
+        }
+    }
+
     if (publish_status_code != 0) {
         Log.errorf(F("Error happened whilst publishing: %S.\r\n"),
                    (PGM_P)pgm_read_word_far(
@@ -769,6 +2516,107 @@ bool MqttClientClass::publish(const char* topic,
     return true;
 }
 
+bool MqttClientClass::publish(const char* topic,
+                              const uint8_t* buffer,
+                              const uint32_t buffer_size,
+                              const MqttQoS quality_of_service,
+                              const uint32_t timeout_ms) {
+
+    if (!isConnected()) {
+        Log.error(F("Attempted publish without being connected to a broker"));
+        LedCtrl.off(Led::DATA, false);
+        return false;
+    }
+
+    LedCtrl.on(Led::DATA, true);
+
+    last_publish_message_id = -1;
+
+    SequansController.writeString(F("AT+SQNSMQTTPUBLISH=0,\"%s\",%u,%lu"),
+                                  true,
+                                  topic,
+                                  quality_of_service,
+                                  buffer_size);
+
+    return deliverPublishPayload(buffer,
+                                 buffer_size,
+                                 quality_of_service,
+                                 timeout_ms);
+}
+
+bool MqttClientClass::publish(const int8_t topic_handle,
+                              const uint8_t* buffer,
+                              const uint32_t buffer_size,
+                              const MqttQoS quality_of_service,
+                              const uint32_t timeout_ms) {
+
+    if (topic_handle < 0 || topic_handle >= num_registered_topics) {
+        Log.errorf(F("Attempted publish with invalid topic handle %d\r\n"),
+                   topic_handle);
+        return false;
+    }
+
+    if (!isConnected()) {
+        Log.error(F("Attempted publish without being connected to a broker"));
+        LedCtrl.off(Led::DATA, false);
+        return false;
+    }
+
+    LedCtrl.on(Led::DATA, true);
+
+    last_publish_message_id = -1;
+
+    const RegisteredTopic* registered_topic = &registered_topics[topic_handle];
+
+    // The topic is copied as is into the command rather than being formatted
+    SequansController.writeString(FV(MQTT_PUBLISH_PREFIX));
+
+    if (registered_topic->is_flash_string) {
+        SequansController.writeString(F("%S"), false, registered_topic->topic);
+    } else {
+        SequansController.writeBytes((const uint8_t*)registered_topic->topic,
+                                     registered_topic->length);
+    }
+
+    SequansController.writeString(F("\",%u,%lu"),
+                                  true,
+                                  quality_of_service,
+                                  buffer_size);
+
+    return deliverPublishPayload(buffer,
+                                 buffer_size,
+                                 quality_of_service,
+                                 timeout_ms);
+}
+
+bool MqttClientClass::publish(const int8_t topic_handle,
+                              const char* message,
+                              const MqttQoS quality_of_service,
+                              const uint32_t timeout_ms) {
+    return publish(topic_handle,
+                   (uint8_t*)message,
+                   strlen(message),
+                   quality_of_service,
+                   timeout_ms);
+}
+
+int8_t MqttClientClass::registerTopic(const char* topic) {
+    return internTopic(topic, false);
+}
+
+int8_t MqttClientClass::registerTopic(const __FlashStringHelper* topic) {
+    return internTopic(reinterpret_cast<const char*>(topic), true);
+}
+
+int8_t MqttClientClass::getTopicHandle(const char* topic) {
+    return findRegisteredTopic(topic, false);
+}
+
+void MqttClientClass::clearRegisteredTopics(void) {
+    num_registered_topics        = 0;
+    registered_topic_pool_length = 0;
+}
+
 bool MqttClientClass::publish(const char* topic,
                               const char* message,
                               const MqttQoS quality_of_service,
@@ -790,7 +2638,7 @@ bool MqttClientClass::subscribe(const char* topic,
     }
 
     const ResponseResult subscribe_result = SequansController.writeCommand(
-        F("AT+SQNSMQTTSUBSCRIBE=0,\"%s\",%u"),
+        FV(MQTT_SUBSCRIBE),
         NULL,
         0,
         topic,
@@ -808,7 +2656,7 @@ bool MqttClientClass::subscribe(const char* topic,
     // termination
     char status_code_buffer[3] = "";
 
-    if (!SequansController.waitForURC(F("SQNSMQTTONSUBSCRIBE"),
+    if (!SequansController.waitForURC(FV(MQTT_ON_SUBSCRIBE_URC),
                                       urc,
                                       sizeof(urc))) {
         Log.error(F("Timed out waiting for subscribe confirmation\r\n"));
@@ -839,6 +2687,45 @@ bool MqttClientClass::subscribe(const char* topic,
         return false;
     }
 
+    if (!rememberSubscription(topic, quality_of_service)) {
+        Log.warnf(F("No space left for remembering the subscription to %s, it "
+                    "will not be replayed when connecting again\r\n"),
+                  topic);
+    }
+
+    return true;
+}
+
+void MqttClientClass::clearSubscriptions(void) {
+    num_subscriptions        = 0;
+    subscription_pool_length = 0;
+}
+
+bool MqttClientClass::subscribe(
+    const char* topic,
+    const MqttQoS quality_of_service,
+    void (*handler)(const char* topic,
+                    const uint16_t message_length,
+                    const int32_t message_id)) {
+
+    // The handler is inserted before subscribing so that messages arriving
+    // right after the subscription are dispatched to it
+    if (!topicTrieInsert(topic, handler)) {
+        Log.errorf(F("Failed to register handler for topic %s. The topic is "
+                     "either invalid or there is no more space for topics "
+                     "with handlers.\r\n"),
+                   topic);
+        return false;
+    }
+
+    SequansController.registerCallback(FV(MQTT_ON_MESSAGE_URC),
+                                       internalOnReceiveCallback);
+
+    if (!subscribe(topic, quality_of_service)) {
+        topicTrieInsert(topic, NULL);
+        return false;
+    }
+
     return true;
 }
 
@@ -846,7 +2733,20 @@ void MqttClientClass::onReceive(void (*callback)(const char* topic,
                                                  const uint16_t message_length,
                                                  const int32_t message_id)) {
     if (callback != NULL) {
-        receive_callback = callback;
+        receive_callback              = callback;
+        receive_topic_handle_callback = NULL;
+        SequansController.registerCallback(FV(MQTT_ON_MESSAGE_URC),
+                                           internalOnReceiveCallback);
+    }
+}
+
+void MqttClientClass::onReceive(void (*callback)(const char* topic,
+                                                 const int8_t topic_handle,
+                                                 const uint16_t message_length,
+                                                 const int32_t message_id)) {
+    if (callback != NULL) {
+        receive_topic_handle_callback = callback;
+        receive_callback              = NULL;
         SequansController.registerCallback(FV(MQTT_ON_MESSAGE_URC),
                                            internalOnReceiveCallback);
     }
@@ -891,20 +2791,343 @@ bool MqttClientClass::readMessage(const char* topic,
     const ResponseResult receive_response =
         SequansController.readResponse(buffer, buffer_size);
 
-    return (receive_response == ResponseResult::OK);
+    if (receive_response != ResponseResult::OK) {
+        return false;
+    }
+
+    markDelivered(message_id);
+
+    return true;
 }
 
 String MqttClientClass::readMessage(const char* topic, const uint16_t size) {
     Log.debugf(F("Reading message on topic %s\r\n"), topic);
 
-    // Add bytes for termination of AT command when reading
-    char buffer[size + 16];
+    String message;
+
+    if (!message.reserve(size)) {
+        return "";
+    }
+
+    // The chunks are appended directly to the string so that the message is
+    // not placed in an intermediate buffer first
+    stream_string_destination = &message;
+    stream_string_capacity    = size;
+
+    const auto append_chunk = [](const uint8_t* chunk,
+                                 const uint16_t chunk_length) {
+        // Messages larger than the size requested are discarded, so don't
+        // grow the string beyond that
+        if (stream_string_destination->length() + chunk_length >
+            stream_string_capacity) {
+            return;
+        }
+
+        char terminated_chunk[MQTT_STREAM_CHUNK_SIZE + 1];
+        memcpy(terminated_chunk, chunk, chunk_length);
+        terminated_chunk[chunk_length] = '\0';
+
+        stream_string_destination->concat(terminated_chunk);
+    };
+
+    uint16_t message_length = 0;
+
+    const ResponseResult result = streamMessage(topic,
+                                                append_chunk,
+                                                &message_length);
+
+    stream_string_destination = NULL;
 
-    if (!readMessage(topic, buffer, sizeof(buffer))) {
+    if (result != ResponseResult::OK || message_length > size) {
         return "";
     }
 
-    return buffer;
+    return message;
+}
+
+/**
+ * @brief Checks whether the bytes held back in the stream ends with the given
+ * termination.
+ */
+static bool streamEndsWith(const char* hold_back,
+                           const uint8_t hold_back_length,
+                           const char* termination) {
+    const uint8_t termination_length = strlen_P(termination);
+
+    return hold_back_length >= termination_length &&
+           memcmp_P(hold_back + hold_back_length - termination_length,
+                    termination,
+                    termination_length) == 0;
+}
+
+ResponseResult
+MqttClientClass::streamMessage(const char* topic,
+                               void (*sink)(const uint8_t* chunk,
+                                            const uint16_t chunk_length),
+                               uint16_t* message_length,
+                               const int32_t message_id) {
+
+    if (message_length != NULL) {
+        *message_length = 0;
+    }
+
+    SequansController.clearReceiveBuffer();
+
+    if (message_id < 0) {
+        SequansController.writeString(FV(MQTT_RECEIVE), true, topic);
+    } else {
+        SequansController.writeString(FV(MQTT_RECEIVE_WITH_MSG_ID),
+                                      true,
+                                      topic,
+                                      (unsigned int)message_id);
+    }
+
+    // First two bytes are \r\n for the MQTT message response, so we flush those
+    if (!SequansController.waitForByte('\r', 100) ||
+        !SequansController.waitForByte('\n', 100)) {
+        return ResponseResult::TIMEOUT;
+    }
+
+    uint8_t chunk[MQTT_STREAM_CHUNK_SIZE];
+    uint16_t chunk_length = 0;
+    uint16_t total_length = 0;
+
+    // The last bytes received are held back until we know that they are not
+    // part of the termination
+    char hold_back[MQTT_STREAM_HOLD_BACK_SIZE];
+    uint8_t hold_back_length = 0;
+
+    ResponseResult result = ResponseResult::NONE;
+
+    while (result == ResponseResult::NONE) {
+
+        const TimeoutTimer timeout_timer(MQTT_STREAM_READ_TIMEOUT_MS);
+
+        while (!SequansController.isRxReady() && !timeout_timer.hasTimedOut()) {
+            _delay_ms(1);
+        }
+
+        if (!SequansController.isRxReady()) {
+            result = ResponseResult::TIMEOUT;
+            break;
+        }
+
+        if (hold_back_length == sizeof(hold_back)) {
+            chunk[chunk_length++] = hold_back[0];
+            memmove(hold_back, hold_back + 1, --hold_back_length);
+
+            if (chunk_length == sizeof(chunk)) {
+                sink(chunk, chunk_length);
+                total_length += chunk_length;
+                chunk_length = 0;
+            }
+        }
+
+        hold_back[hold_back_length++] = (char)SequansController.readByte();
+
+        if (streamEndsWith(hold_back, hold_back_length, PSTR("\r\nOK\r\n"))) {
+            hold_back_length -= strlen_P(PSTR("\r\nOK\r\n"));
+            result = ResponseResult::OK;
+        } else if (streamEndsWith(hold_back,
+                                  hold_back_length,
+                                  PSTR("\r\nERROR\r\n"))) {
+            hold_back_length -= strlen_P(PSTR("\r\nERROR\r\n"));
+            result = ResponseResult::ERROR;
+        } else if (total_length == 0 && chunk_length == 0 &&
+                   hold_back_length == strlen_P(PSTR("ERROR\r\n")) &&
+                   streamEndsWith(hold_back,
+                                  hold_back_length,
+                                  PSTR("ERROR\r\n"))) {
+            // No message, the leading line termination of the error was
+            // consumed above
+            result = ResponseResult::ERROR;
+        }
+    }
+
+    if (result == ResponseResult::OK) {
+
+        // Omit the line termination the modem places after the payload
+        if (streamEndsWith(hold_back, hold_back_length, PSTR("\r\n"))) {
+            hold_back_length -= 2;
+        }
+
+        for (uint8_t i = 0; i < hold_back_length; i++) {
+            chunk[chunk_length++] = hold_back[i];
+
+            if (chunk_length == sizeof(chunk)) {
+                sink(chunk, chunk_length);
+                total_length += chunk_length;
+                chunk_length = 0;
+            }
+        }
+
+        if (chunk_length > 0) {
+            sink(chunk, chunk_length);
+            total_length += chunk_length;
+        }
+
+        markDelivered(message_id);
+    }
+
+    if (message_length != NULL) {
+        *message_length = total_length;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Drains the notified messages into the inbound queue whilst the modem
+ * is awake, so that they are not left in the modem.
+ */
+static void fetchMessagesBeforeSleep(void) { MqttClient.fetchMessages(); }
+
+void MqttClientClass::enableInboundQueue(const bool enable) {
+    inbound_queue_enabled = enable;
+
+    if (enable) {
+        SequansController.registerCallback(FV(MQTT_ON_MESSAGE_URC),
+                                           internalOnReceiveCallback);
+
+        LowPower.registerPreSleepCallback(fetchMessagesBeforeSleep);
+    } else {
+        LowPower.unregisterPreSleepCallback(fetchMessagesBeforeSleep);
+    }
+}
+
+uint8_t MqttClientClass::fetchMessages(const uint32_t quiet_period_ms) {
+
+    // Wait for the burst of notifications to end, so that the fetching isn't
+    // interleaved with new notifications
+    while (true) {
+        cli();
+        const uint32_t last_announcement_ms = inbound_last_announcement_ms;
+        sei();
+
+        if (millis() - last_announcement_ms >= quiet_period_ms) {
+            break;
+        }
+
+        _delay_ms(1);
+    }
+
+    uint8_t messages_fetched = 0;
+
+    while (inbound_pending_count > 0) {
+
+        cli();
+        const InboundAnnouncement announcement =
+            inbound_pending[inbound_pending_head];
+        sei();
+
+        const uint16_t size_needed = INBOUND_HEADER_SIZE +
+                                     announcement.message_length;
+
+        if (size_needed > MQTT_INBOUND_QUEUE_SIZE - inbound_ring_used) {
+            // Leave the rest on the modem until there is space
+            break;
+        }
+
+        const uint16_t header_index = inboundRingIndex(inbound_ring_tail,
+                                                       inbound_ring_used);
+
+        inbound_stream_index = inboundRingIndex(header_index,
+                                                INBOUND_HEADER_SIZE);
+        inbound_stream_remaining = announcement.message_length;
+
+        uint16_t message_length = 0;
+
+        const ResponseResult result = streamMessage(
+            inbound_topics[announcement.topic_index],
+            inboundStreamSink,
+            &message_length,
+            announcement.message_id);
+
+        cli();
+        inbound_pending_head = (inbound_pending_head + 1) %
+                               MQTT_INBOUND_MAX_PENDING;
+        inbound_pending_count--;
+        sei();
+
+        if (result != ResponseResult::OK) {
+            Log.warnf(F("Failed to fetch MQTT message on topic %s\r\n"),
+                      inbound_topics[announcement.topic_index]);
+
+            releaseInboundTopic(announcement.topic_index);
+            continue;
+        }
+
+        // The message might be shorter than announced
+        message_length = min(message_length, announcement.message_length);
+
+        inboundRingWrite(header_index, &announcement.topic_index, 1);
+        inboundRingWrite(inboundRingIndex(header_index, 1),
+                         &announcement.message_id,
+                         sizeof(announcement.message_id));
+        inboundRingWrite(inboundRingIndex(header_index,
+                                          1 + sizeof(announcement.message_id)),
+                         &message_length,
+                         sizeof(message_length));
+
+        inbound_ring_used += INBOUND_HEADER_SIZE + message_length;
+        inbound_queued_messages++;
+        messages_fetched++;
+    }
+
+    return messages_fetched;
+}
+
+uint8_t MqttClientClass::queuedMessages(void) {
+    return inbound_queued_messages;
+}
+
+bool MqttClientClass::readQueuedMessage(char* topic,
+                                        const uint16_t topic_size,
+                                        uint8_t* buffer,
+                                        const uint16_t buffer_size,
+                                        uint16_t* message_length,
+                                        int32_t* message_id) {
+
+    if (inbound_queued_messages == 0) {
+        return false;
+    }
+
+    uint8_t topic_index = 0;
+    int32_t id          = 0;
+    uint16_t length     = 0;
+
+    inboundRingRead(inbound_ring_tail, &topic_index, 1);
+    inboundRingRead(inboundRingIndex(inbound_ring_tail, 1), &id, sizeof(id));
+    inboundRingRead(inboundRingIndex(inbound_ring_tail, 1 + sizeof(id)),
+                    &length,
+                    sizeof(length));
+
+    if (message_length != NULL) {
+        *message_length = length;
+    }
+
+    if (length > buffer_size ||
+        strlen(inbound_topics[topic_index]) >= topic_size) {
+        return false;
+    }
+
+    strcpy(topic, inbound_topics[topic_index]);
+    inboundRingRead(inboundRingIndex(inbound_ring_tail, INBOUND_HEADER_SIZE),
+                    buffer,
+                    length);
+
+    if (message_id != NULL) {
+        *message_id = id;
+    }
+
+    inbound_ring_tail = inboundRingIndex(inbound_ring_tail,
+                                         INBOUND_HEADER_SIZE + length);
+    inbound_ring_used -= INBOUND_HEADER_SIZE + length;
+    inbound_queued_messages--;
+
+    releaseInboundTopic(topic_index);
+
+    return true;
 }
 
 void MqttClientClass::clearMessages(const char* topic,
@@ -5,14 +5,126 @@
 #ifndef MQTT_CLIENT_H
 #define MQTT_CLIENT_H
 
+#include "eeprom_layout.h"
+#include "mqtt_config.h"
+#include "sequans_controller.h"
+
 #include <Arduino.h>
 #include <stdbool.h>
 #include <stdint.h>
 
-#define MQTT_TOPIC_MAX_LENGTH (384)
+/**
+ * @brief Size of the chunks passed to the sink in
+ * MqttClientClass::streamMessage().
+ */
+#define MQTT_STREAM_CHUNK_SIZE (64)
+
+/**
+ * @brief Default time without new message notifications before
+ * MqttClientClass::fetchMessages() regards the burst of notifications as done.
+ */
+#define MQTT_INBOUND_QUIET_PERIOD_MS (100)
+
+/**
+ * @brief Time an incoming QoS 2 message ID is regarded as not released by the
+ * broker after the message has been read, i.e. the bound on the PUBREC/PUBREL
+ * round trip. Within this time an announcement with the same ID is a
+ * redelivery, after it the ID may have been reused for a new message.
+ */
+#define MQTT_QOS2_PUBREL_TIMEOUT_MS (10000UL)
+
+/**
+ * @brief Added to the power save mode period to get the keep-alive when
+ * adaptive keep-alive is enabled, see
+ * MqttClientClass::enableAdaptiveKeepAlive(). Covers the time it takes for the
+ * modem to wake up and reach the broker.
+ */
+#define MQTT_PSM_KEEP_ALIVE_MARGIN_S (60)
+
+/**
+ * @brief Default bounds for the backoff between the attempts of the reconnect
+ * engine, see MqttClientClass::enableAutoReconnect().
+ */
+#define MQTT_RECONNECT_MIN_BACKOFF_MS (2000UL)
+#define MQTT_RECONNECT_MAX_BACKOFF_MS (600000UL)
 
 typedef enum { AT_MOST_ONCE = 0, AT_LEAST_ONCE, EXACTLY_ONCE } MqttQoS;
 
+/**
+ * @brief Delivery state of a QoS 2 (EXACTLY_ONCE) message.
+ */
+enum class MqttDeliveryState : uint8_t {
+    // The message ID is not in the state table
+    UNKNOWN = 0,
+    // Incoming message announced by the modem, but not read yet
+    RECEIVED,
+    // Incoming message read, redeliveries of it will be discarded until the
+    // broker has released the message ID
+    DELIVERED,
+    // Outgoing message acknowledged by the broker (PUBCOMP)
+    PUBLISHED,
+    // Outgoing message rejected by the broker or the modem
+    PUBLISH_FAILED
+};
+
+typedef struct {
+    /**
+     * @brief Connection attempts made by the reconnect engine.
+     */
+    uint16_t attempts;
+
+    /**
+     * @brief Successful reconnects made by the reconnect engine.
+     */
+    uint16_t reconnects;
+
+    /**
+     * @brief Time from the connection was lost until it was re-established
+     * for the last reconnect.
+     */
+    uint32_t last_outage_ms;
+
+    uint32_t longest_outage_ms;
+
+    /**
+     * @brief Time from the connection was requested until the broker
+     * accepted it for the last reconnect.
+     */
+    uint32_t last_connect_duration_ms;
+} MqttReconnectStatistics;
+
+/**
+ * @brief Breakdown of the time spent in the phases of the last connection to
+ * the broker.
+ */
+typedef struct {
+    /**
+     * @brief Time from the connection was requested until the modem asked for
+     * the TLS handshake to be signed. Zero if the ECC is not used.
+     */
+    uint32_t modem_tls_ms;
+
+    /**
+     * @brief Time spent by the ECC on signing, including waking it and the I2C
+     * transfers.
+     */
+    uint32_t ecc_sign_ms;
+
+    /**
+     * @brief Time spent writing the signature to the modem over UART.
+     */
+    uint32_t uart_write_ms;
+
+    /**
+     * @brief Time from the signature was written (or the connection was
+     * requested if the ECC is not used) until the broker accepted the
+     * connection.
+     */
+    uint32_t broker_ms;
+
+    uint32_t total_ms;
+} MqttConnectTimings;
+
 class MqttClientClass {
 
   private:
@@ -33,6 +145,9 @@ class MqttClientClass {
 
     /**
      * @brief Will configure and connect to the host/broker specified.
+     * Subscriptions made previously with #subscribe() are replayed after the
+     * connection is made. The subscribe commands for these are issued back to
+     * back and the confirmations are collected afterwards.
      *
      * @param client_id The identifier for this unit.
      * @param host Host/broker to attempt to connect to.
@@ -40,7 +155,8 @@ class MqttClientClass {
      * @param use_tls Whether to use TLS in the communication.
      * @param keep_alive Optional: How often the broker is pinged. If low power
      * is utilised, the modem will wake up every @p keep_alive to ping the
-     * broker regardless of the sleeping time.
+     * broker regardless of the sleeping time. Overridden by the power save
+     * mode period if #enableAdaptiveKeepAlive() is used.
      * @param use_ecc Optional: Whether to use the ECC for signing messages. If
      * not used, the private key has to be stored on the modem and the
      * security profile has to be be set up to not use external hardware
@@ -51,7 +167,9 @@ class MqttClientClass {
      * @param print_messages: If set to true, prints "Connecting to MQTT
      * broker..."
      *
-     * @return true if configuration and connection was succesful.
+     * @return true if configuration and connection was succesful. Failing to
+     * replay the previous subscriptions is logged, but does not affect the
+     * return value.
      */
     bool begin(const char* client_id,
                const char* host,
@@ -80,6 +198,104 @@ class MqttClientClass {
      */
     bool end();
 
+    /**
+     * @brief When enabled, the keep-alive passed to #begin() is replaced by
+     * the power save mode period granted by the operator (see
+     * LowPowerClass::getPowerSaveModePeriod()) plus
+     * #MQTT_PSM_KEEP_ALIVE_MARGIN_S. This way the modem doesn't have to wake up
+     * to ping the broker whilst sleeping, and the broker doesn't drop the
+     * connection. Has no effect if power save mode is not configured.
+     *
+     * If the reconnect engine is enabled, #poll() reconnects with the new
+     * keep-alive when the period granted by the operator changes. Otherwise
+     * it takes effect with the next call to #begin().
+     */
+    void enableAdaptiveKeepAlive(const bool enable = true);
+
+    /**
+     * @return The keep-alive in seconds used for the current or last
+     * connection.
+     */
+    uint16_t getKeepAlive(void);
+
+    /**
+     * @return The message ID of the last publish which got a confirmation
+     * from the modem, or -1 if there is none.
+     */
+    int32_t getLastPublishMessageId(void);
+
+    /**
+     * @return Delivery state of the outgoing QoS 2 message with the given ID.
+     */
+    MqttDeliveryState getPublishState(const uint16_t message_id);
+
+    /**
+     * @brief Incoming QoS 2 messages are tracked by their message ID. Once a
+     * message has been read, redeliveries of it within the same connection
+     * and within #MQTT_QOS2_PUBREL_TIMEOUT_MS are not passed on to the receive
+     * callbacks, and are discarded from the modem by #poll(). As the modem only
+     * supports clean sessions, the incoming message IDs are forgotten on every
+     * new connection, where the broker starts numbering them again.
+     *
+     * @return Delivery state of the incoming QoS 2 message with the given ID.
+     */
+    MqttDeliveryState getReceiveState(const uint16_t message_id);
+
+    /**
+     * @brief Clears the QoS 2 delivery state table, both in RAM and in
+     * EEPROM. Should be done when the broker no longer holds a session for
+     * the client, as message IDs are then reused.
+     */
+    void clearDeliveryStates(void);
+
+    /**
+     * @brief Enables the reconnect engine. When the connection to the broker is
+     * lost, the engine will reconnect with the configuration from the last
+     * call to #begin() without blocking. The attempts are spaced with an
+     * exponential backoff between @p min_backoff_ms and @p max_backoff_ms,
+     * where half of the backoff is random so that devices losing the
+     * connection at the same time don't reconnect at the same time. The
+     * previous subscriptions are replayed when the connection is
+     * re-established.
+     *
+     * @note The engine is driven by #poll(), which has to be called
+     * regularly. Call #disableAutoReconnect() before #end() if the connection
+     * should stay closed.
+     *
+     * @note The modem does not support persistent sessions, so messages
+     * published to the client whilst it is disconnected are not delivered.
+     */
+    void
+    enableAutoReconnect(const uint32_t min_backoff_ms = MQTT_RECONNECT_MIN_BACKOFF_MS,
+                        const uint32_t max_backoff_ms = MQTT_RECONNECT_MAX_BACKOFF_MS);
+
+    /**
+     * @brief Disables the reconnect engine and aborts any ongoing reconnect.
+     */
+    void disableAutoReconnect(void);
+
+    /**
+     * @brief Drives the reconnect engine if enabled, discards redelivered QoS
+     * 2 messages from the modem and persists the QoS 2 delivery state table.
+     * Does not wait for the broker, only for the responses of the modem to
+     * the configuration and subscribe commands. The confirmations of the
+     * replayed subscriptions are collected over the following calls.
+     *
+     * @return true if connected to the broker.
+     */
+    bool poll(void);
+
+    /**
+     * @return Timing statistics for the reconnect engine.
+     */
+    MqttReconnectStatistics getReconnectStatistics(void);
+
+    /**
+     * @return Timing breakdown of the last connection to the broker, either
+     * by #begin() or by the reconnect engine.
+     */
+    MqttConnectTimings getConnectTimings(void);
+
     /**
      * @brief Register callback function for when the client is
      * connected/disconnected to/from the MQTT broker. Called from ISR, so keep
@@ -114,6 +330,10 @@ class MqttClientClass {
      * @param quality_of_service MQTT protocol QoS.
      * @param timeout_ms Timeout waiting for publish confirmation.
      *
+     * @note For EXACTLY_ONCE the confirmation arrives after the broker has
+     * completed the PUBREC/PUBREL/PUBCOMP exchange, and the outcome is kept in
+     * the delivery state table, see #getPublishState().
+     *
      * @return true if publish was successful.
      */
     bool publish(const char* topic,
@@ -138,7 +358,71 @@ class MqttClientClass {
                  const uint32_t timeout_ms        = 30000);
 
     /**
-     * @brief Subscribes to a given topic.
+     * @brief Registers a topic so that it can be published to by a handle
+     * with the publish overloads taking a topic handle. The topic is copied
+     * into the client, so the string doesn't have to outlive this call.
+     * Registering a topic which is already registered returns the existing
+     * handle.
+     *
+     * @return The handle for the topic, or -1 if the topic is invalid or there
+     * is no space left for it.
+     */
+    int8_t registerTopic(const char* topic);
+
+    /**
+     * @brief Flash string version of #registerTopic(), which only keeps a
+     * reference to the topic and doesn't use any of the pool.
+     */
+    int8_t registerTopic(const __FlashStringHelper* topic);
+
+    /**
+     * @brief Maps the topic of an incoming message to the handle it was
+     * registered with. The lookup is done by a hash of the topic. The
+     * callback registered with the handle version of #onReceive() is given
+     * the handle directly.
+     *
+     * @return The handle or -1 if the topic is not registered.
+     */
+    int8_t getTopicHandle(const char* topic);
+
+    /**
+     * @brief Removes all the registered topics. Handles returned previously
+     * are no longer valid.
+     */
+    void clearRegisteredTopics(void);
+
+    /**
+     * @brief Publishes the contents of the buffer to the topic registered with
+     * @p topic_handle. The topic is copied into the publish command directly,
+     * so the command is cheaper to issue than with a topic string.
+     *
+     * @param topic_handle Handle returned by #registerTopic().
+     *
+     * @return true if publish was successful.
+     */
+    bool publish(const int8_t topic_handle,
+                 const uint8_t* buffer,
+                 const uint32_t buffer_size,
+                 const MqttQoS quality_of_service = AT_LEAST_ONCE,
+                 const uint32_t timeout_ms        = 30000);
+
+    /**
+     * @brief Publishes the message to the topic registered with @p
+     * topic_handle.
+     *
+     * @param topic_handle Handle returned by #registerTopic().
+     * @param message String to publish, has to be null terminated.
+     *
+     * @return true if publish was successful.
+     */
+    bool publish(const int8_t topic_handle,
+                 const char* message,
+                 const MqttQoS quality_of_service = AT_LEAST_ONCE,
+                 const uint32_t timeout_ms        = 30000);
+
+    /**
+     * @brief Subscribes to a given topic. The subscription is remembered and
+     * replayed when connecting to the broker again with #begin().
      *
      * @param topic Topic to subscribe to.
      * @param quality_of_service MQTT protocol QoS.
@@ -148,9 +432,41 @@ class MqttClientClass {
     bool subscribe(const char* topic,
                    const MqttQoS quality_of_service = AT_MOST_ONCE);
 
+    /**
+     * @brief Subscribes to a given topic and registers a handler which will be
+     * called when a message is received on a topic matching @p topic. The
+     * topic can contain the single level (+) and multi level (#) wildcards.
+     * If a received message matches several subscriptions, every matching
+     * handler is called. Messages not matching any handler are passed on to
+     * the callback registered with #onReceive(). Called from ISR, so keep the
+     * handler short.
+     *
+     * @param topic Topic (filter) to subscribe to.
+     * @param quality_of_service MQTT protocol QoS.
+     * @param handler Called with the topic the message was received on, the
+     * message length and the message ID (-1 if the MqttQoS is AT_MOST_ONCE).
+     *
+     * @return true if subscription was successful. False if the subscription
+     * failed or if there was no more space for the topic in the trie (see
+     * #MQTT_TOPIC_TRIE_MAX_NODES and #MQTT_TOPIC_TRIE_POOL_SIZE).
+     */
+    bool subscribe(const char* topic,
+                   const MqttQoS quality_of_service,
+                   void (*handler)(const char* topic,
+                                   const uint16_t message_length,
+                                   const int32_t message_id));
+
+    /**
+     * @brief Forgets the subscriptions made, so that they are not replayed when
+     * connecting to the broker again. Does not unsubscribe from the topics on
+     * the current connection. Handlers registered with #subscribe() are kept.
+     */
+    void clearSubscriptions(void);
+
     /**
      * @brief Register a callback function which will be called when we receive
-     * a message on any topic we've subscribed on. Called from ISR, so keep this
+     * a message on any topic we've subscribed on which is not handled by a
+     * handler registered with #subscribe(). Called from ISR, so keep this
      * function short.
      *
      * @param message_id This value will be -1 if the MqttQoS is set to
@@ -160,6 +476,23 @@ class MqttClientClass {
                                     const uint16_t message_length,
                                     const int32_t message_id));
 
+    /**
+     * @brief Version of #onReceive() where the callback is also given the
+     * handle the topic of the message was registered with (see
+     * #registerTopic()), so that the topic doesn't have to be compared with
+     * strings. The topic is looked up by a hash. Replaces a callback
+     * registered with the other version and vice versa.
+     *
+     * @param topic_handle The handle of the topic or -1 if the topic is not
+     * registered.
+     * @param message_id This value will be -1 if the MqttQoS is set to
+     * AT_MOST_ONCE.
+     */
+    void onReceive(void (*callback)(const char* topic,
+                                    const int8_t topic_handle,
+                                    const uint16_t message_length,
+                                    const int32_t message_id));
+
     /**
      * @brief Reads the message received on the given topic (if any).
      *
@@ -189,6 +522,81 @@ class MqttClientClass {
      */
     String readMessage(const char* topic, const uint16_t size = 256);
 
+    /**
+     * @brief Reads the message received on the given topic (if any) and
+     * passes the payload to @p sink in chunks of at most
+     * #MQTT_STREAM_CHUNK_SIZE bytes as they are received from the modem. In
+     * that way the message does not have to be placed in a buffer of its full
+     * size, and it can e.g. be parsed incrementally.
+     *
+     * @param topic Topic message received on.
+     * @param sink Called with every chunk of the payload in order.
+     * @param message_length If not NULL, the total amount of bytes passed to
+     * @p sink is placed here.
+     * @param message_id If QoS is not MqttQoS::AT_MOST_ONCE, we get a message
+     * ID during the callback. This has to be specified here. If this argument
+     * is -1, message ID will not be passed when retrieving the message.
+     *
+     * @return The following status codes:
+     * - OK if the whole message was read.
+     * - ERROR if the modem reported an error, e.g. if there were no message.
+     * - TIMEOUT if the modem stopped sending data before the message ended.
+     */
+    ResponseResult streamMessage(const char* topic,
+                                 void (*sink)(const uint8_t* chunk,
+                                              const uint16_t chunk_length),
+                                 uint16_t* message_length = NULL,
+                                 const int32_t message_id = -1);
+
+    /**
+     * @brief Enables or disables the inbound queue. When enabled, incoming
+     * messages are not passed to the receive callbacks, but are noted and
+     * fetched from the modem into a RAM ring with #fetchMessages(). They can
+     * then be consumed later with #readQueuedMessage(). This allows for
+     * draining the messages from the modem in one burst whilst the modem is
+     * awake, e.g. right after waking up from power save. The messages are
+     * also fetched by LowPower.powerSave() before the modem goes to sleep.
+     */
+    void enableInboundQueue(const bool enable = true);
+
+    /**
+     * @brief Waits until no new message notifications have arrived for @p
+     * quiet_period_ms and then fetches all the notified messages from the
+     * modem into the inbound queue, as long as there is space for them.
+     *
+     * @return The number of messages fetched.
+     */
+    uint8_t
+    fetchMessages(const uint32_t quiet_period_ms = MQTT_INBOUND_QUIET_PERIOD_MS);
+
+    /**
+     * @return The number of messages in the inbound queue.
+     */
+    uint8_t queuedMessages(void);
+
+    /**
+     * @brief Reads and removes the oldest message in the inbound queue.
+     *
+     * @param topic Buffer to place the topic the message was received on.
+     * @param topic_size Size of @p topic.
+     * @param buffer Buffer to place the message. Not NULL terminated.
+     * @param buffer_size Size of @p buffer.
+     * @param message_length Set to the length of the message if not NULL,
+     * also if the buffers are too small.
+     * @param message_id Set to the message ID if not NULL. -1 if the MqttQoS
+     * was AT_MOST_ONCE.
+     *
+     * @return true if a message was read. False if the queue is empty or if
+     * the buffers are too small, in which case the message is kept in the
+     * queue.
+     */
+    bool readQueuedMessage(char* topic,
+                           const uint16_t topic_size,
+                           uint8_t* buffer,
+                           const uint16_t buffer_size,
+                           uint16_t* message_length = NULL,
+                           int32_t* message_id      = NULL);
+
     /**
      * @brief Reads @p num_messages MQTT messages from the Sequans modem and
      * discards them.
@@ -0,0 +1,131 @@
+/**
+ * @brief Sizes of the static buffers and pools of the MQTT client. The
+ * library's own sources include this header, so a value changed here or
+ * given as a compiler flag (e.g. -DMQTT_TOPIC_MAX_LENGTH=64) applies to both
+ * the library and the sketch. A define in a sketch does not reach the sources
+ * of the library and thus has no effect.
+ */
+
+#ifndef MQTT_CONFIG_H
+#define MQTT_CONFIG_H
+
+/**
+ * @brief Maximum length of the topics the client handles, which sizes the
+ * buffers used for the notifications of incoming messages. Messages on a
+ * wildcard subscription can arrive on any topic, so this has to cover every
+ * topic the broker can send on, not only the registered ones. Messages on
+ * longer topics are dropped. The default covers the topic limit of AWS IoT,
+ * but e.g. Azure cloud-to-device topics carry the message properties and can
+ * be longer.
+ */
+#ifndef MQTT_TOPIC_MAX_LENGTH
+#define MQTT_TOPIC_MAX_LENGTH (256)
+#endif
+
+/**
+ * @brief Maximum amount of topics which can be registered with
+ * MqttClientClass::registerTopic(), and the size of the pool which holds the
+ * topics registered from RAM (including NULL termination). Topics registered
+ * from flash only occupy an entry.
+ */
+#ifndef MQTT_MAX_REGISTERED_TOPICS
+#define MQTT_MAX_REGISTERED_TOPICS (8)
+#endif
+
+#ifndef MQTT_REGISTERED_TOPIC_POOL_SIZE
+#define MQTT_REGISTERED_TOPIC_POOL_SIZE (64)
+#endif
+
+/**
+ * @brief Maximum amount of topic levels which can be held in the trie used to
+ * dispatch received messages to the handlers registered with
+ * MqttClientClass::subscribe(). Topic levels shared between subscriptions (e.g.
+ * "device" in "device/a" and "device/b") only occupy one node.
+ */
+#ifndef MQTT_TOPIC_TRIE_MAX_NODES
+#define MQTT_TOPIC_TRIE_MAX_NODES (32)
+#endif
+
+/**
+ * @brief Size of the pool holding the names of the topic levels in the trie.
+ * Identical level names are only stored once. At most 256.
+ */
+#ifndef MQTT_TOPIC_TRIE_POOL_SIZE
+#define MQTT_TOPIC_TRIE_POOL_SIZE (256)
+#endif
+
+/**
+ * @brief Maximum amount of subscriptions remembered by the client and the size
+ * of the pool holding their topics (including NULL termination). The
+ * subscriptions are replayed when connecting to the broker again.
+ */
+#ifndef MQTT_MAX_SUBSCRIPTIONS
+#define MQTT_MAX_SUBSCRIPTIONS (8)
+#endif
+
+#ifndef MQTT_SUBSCRIPTION_POOL_SIZE
+#define MQTT_SUBSCRIPTION_POOL_SIZE (192)
+#endif
+
+/**
+ * @brief Size of the RAM ring holding messages fetched with
+ * MqttClientClass::fetchMessages(). Every message occupies its length plus a
+ * header of 7 bytes. Messages which don't fit in the ring are passed to the
+ * receive callbacks instead.
+ */
+#ifndef MQTT_INBOUND_QUEUE_SIZE
+#define MQTT_INBOUND_QUEUE_SIZE (384)
+#endif
+
+/**
+ * @brief Amount of message notifications which can be waiting to be fetched
+ * into the inbound queue.
+ */
+#ifndef MQTT_INBOUND_MAX_PENDING
+#define MQTT_INBOUND_MAX_PENDING (8)
+#endif
+
+/**
+ * @brief Amount of distinct topics which can be referenced by the messages in
+ * the inbound queue at once, and the maximum length of them (including NULL
+ * termination). Messages on other topics are passed on to the receive
+ * callbacks as if the inbound queue was disabled.
+ */
+#ifndef MQTT_INBOUND_MAX_TOPICS
+#define MQTT_INBOUND_MAX_TOPICS (4)
+#endif
+
+#ifndef MQTT_INBOUND_TOPIC_LENGTH
+#define MQTT_INBOUND_TOPIC_LENGTH (64)
+#endif
+
+/**
+ * @brief Number of QoS 2 message IDs of which the delivery state is tracked,
+ * see MqttClientClass::getReceiveState() and
+ * MqttClientClass::getPublishState(). The oldest entry is replaced when the
+ * table is full. The table is persisted in EEPROM (see eeprom_layout.h), but
+ * only the states of outgoing messages are kept across a reset or a power
+ * down, as the incoming message IDs are forgotten on every new connection.
+ */
+#ifndef MQTT_QOS2_STATE_TABLE_SIZE
+#define MQTT_QOS2_STATE_TABLE_SIZE (16)
+#endif
+
+/**
+ * @brief Number of redelivered QoS 2 messages which can wait to be discarded
+ * from the modem by MqttClientClass::poll().
+ */
+#ifndef MQTT_QOS2_MAX_PENDING_DISCARDS
+#define MQTT_QOS2_MAX_PENDING_DISCARDS (2)
+#endif
+
+/**
+ * @brief Size of the pool holding the client ID, host, username and password
+ * (including NULL termination) from the last call to MqttClientClass::begin(),
+ * which the reconnect engine uses.
+ */
+#ifndef MQTT_RECONNECT_CONFIG_POOL_SIZE
+#define MQTT_RECONNECT_CONFIG_POOL_SIZE (256)
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+#include "network_time.h"
+#include "log.h"
+#include "sequans_controller.h"
+
+#include <stdio.h>
+
+#define SECONDS_PER_DAY (86400UL)
+
+NetworkTimeClass NetworkTime = NetworkTimeClass::instance();
+
+static bool synced = false;
+
+/**
+ * @brief The epoch read from the modem and the value of millis() at that time.
+ */
+static uint32_t anchor_epoch = 0;
+static uint32_t anchor_ms    = 0;
+
+static int16_t timezone_offset_minutes = 0;
+
+static uint32_t last_sync_attempt_ms = 0;
+static bool has_attempted_sync       = false;
+
+/**
+ * @brief Converts a date to days since 1970-01-01.
+ */
+static int32_t daysFromCivil(int16_t year, const uint8_t month, uint8_t day) {
+
+    // Shift the year to start in March so that the leap day is at the end
+    year -= month <= 2;
+
+    const int16_t era          = (year >= 0 ? year : year - 399) / 400;
+    const uint16_t year_of_era = year - era * 400;
+    const uint16_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) /
+                                     5 +
+                                 day - 1;
+    const uint32_t day_of_era  = (uint32_t)year_of_era * 365 +
+                                year_of_era / 4 - year_of_era / 100 +
+                                day_of_year;
+
+    return (int32_t)era * 146097 + (int32_t)day_of_era - 719468;
+}
+
+bool NetworkTimeClass::sync(void) {
+
+    last_sync_attempt_ms = millis();
+    has_attempted_sync   = true;
+
+    if (!SequansController.isInitialized()) {
+        return false;
+    }
+
+    char response[48]    = "";
+    char clock_value[32] = "";
+
+    if (SequansController.writeCommand(F("AT+CCLK?"),
+                                       response,
+                                       sizeof(response)) !=
+            ResponseResult::OK ||
+        !SequansController.extractValueFromCommandResponse(
+            response,
+            0,
+            clock_value,
+            sizeof(clock_value))) {
+        return false;
+    }
+
+    // The clock is given as "yy/MM/dd,hh:mm:ss+zz" in local time, where the
+    // time zone is in quarters of an hour
+    unsigned int year, month, day, hour, minute, second;
+    int time_zone = 0;
+
+    if (sscanf(clock_value,
+               "\"%u/%u/%u,%u:%u:%u%d",
+               &year,
+               &month,
+               &day,
+               &hour,
+               &minute,
+               &second,
+               &time_zone) < 6) {
+        return false;
+    }
+
+    const uint32_t epoch = (uint32_t)daysFromCivil(2000 + year, month, day) *
+                               SECONDS_PER_DAY +
+                           (uint32_t)hour * 3600 + minute * 60 + second -
+                           (int32_t)time_zone * 15 * 60;
+
+    // The clock of the modem has not been set by the network, and wraps
+    // around to 1970 as it is given with two digits for the year
+    if (year >= 70 || epoch < NETWORK_TIME_MIN_VALID_EPOCH) {
+        return false;
+    }
+
+    anchor_epoch            = epoch;
+    anchor_ms               = millis();
+    timezone_offset_minutes = time_zone * 15;
+    synced                  = true;
+
+    return true;
+}
+
+bool NetworkTimeClass::isSynced(void) { return synced; }
+
+uint32_t NetworkTimeClass::now(void) {
+
+    const bool can_attempt_sync =
+        !has_attempted_sync ||
+        millis() - last_sync_attempt_ms >= NETWORK_TIME_RETRY_INTERVAL_MS;
+
+    if (!synced) {
+        if (!can_attempt_sync || !sync()) {
+            return 0;
+        }
+    } else if (millis() - anchor_ms >= NETWORK_TIME_RESYNC_INTERVAL_MS &&
+               can_attempt_sync) {
+
+        // Keep the time from the old anchor if the modem can't be reached
+        if (!sync()) {
+            Log.debug(F("Failed to resynchronize the network time"));
+        }
+    }
+
+    return anchor_epoch + (millis() - anchor_ms) / 1000;
+}
+
+int16_t NetworkTimeClass::getTimezoneOffset(void) {
+    return timezone_offset_minutes;
+}
+
+void NetworkTimeClass::addElapsedTime(const uint32_t elapsed_ms) {
+
+    // Moving the anchor back makes the elapsed time count towards both the
+    // time and the drift bound
+    anchor_ms -= elapsed_ms;
+}
+
+void NetworkTimeClass::invalidate(void) { synced = false; }
@@ -0,0 +1,100 @@
+/**
+ * @brief Network time kept on the MCU. The time of the modem, which it gets
+ * from the operator or NTP, is read once and anchored to millis(), so that the
+ * time can be retrieved without a command to the modem. The time is kept
+ * across LowPowerClass::powerDown() by the PIT, and read from the modem again
+ * when the drift of millis() might have exceeded #NETWORK_TIME_MAX_ERROR_MS.
+ */
+
+#ifndef NETWORK_TIME_H
+#define NETWORK_TIME_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * @brief Worst case drift of millis() in parts per million, from the tolerance
+ * of the internal oscillator.
+ */
+#ifndef NETWORK_TIME_DRIFT_PPM
+#define NETWORK_TIME_DRIFT_PPM (2000UL)
+#endif
+
+/**
+ * @brief Error which is tolerated before the time is read from the modem again.
+ */
+#ifndef NETWORK_TIME_MAX_ERROR_MS
+#define NETWORK_TIME_MAX_ERROR_MS (2000UL)
+#endif
+
+#define NETWORK_TIME_RESYNC_INTERVAL_MS \
+    (NETWORK_TIME_MAX_ERROR_MS * (1000000UL / NETWORK_TIME_DRIFT_PPM))
+
+/**
+ * @brief Minimum interval between attempts to read the time from the modem if
+ * it fails, e.g. because the modem is not started.
+ */
+#define NETWORK_TIME_RETRY_INTERVAL_MS (60000UL)
+
+/**
+ * @brief Times before this (2020-01-01) are regarded as the modem not having
+ * got the time yet, as its clock starts at 1970-01-01.
+ */
+#define NETWORK_TIME_MIN_VALID_EPOCH (1577836800UL)
+
+class NetworkTimeClass {
+
+  private:
+    NetworkTimeClass(){};
+
+  public:
+    static NetworkTimeClass& instance(void) {
+        static NetworkTimeClass instance;
+        return instance;
+    }
+
+    /**
+     * @brief Reads the time from the modem with AT+CCLK? and anchors it to
+     * millis(). Requires the modem to be started.
+     *
+     * @return false if the time could not be read or the modem has not got
+     * the time from the network yet. The previous anchor is kept then.
+     */
+    bool sync(void);
+
+    /**
+     * @return true if the time has been read from the modem.
+     */
+    bool isSynced(void);
+
+    /**
+     * @brief Retrieves the current time without a command to the modem,
+     * unless the drift bound has been exceeded and the time has to be read
+     * again.
+     *
+     * @return Seconds since 1970-01-01 in UTC, or 0 if the time is not known.
+     */
+    uint32_t now(void);
+
+    /**
+     * @return The offset of the local time zone from UTC in minutes, as
+     * reported by the network.
+     */
+    int16_t getTimezoneOffset(void);
+
+    /**
+     * @brief Accounts for time which has passed whilst millis() was stopped,
+     * e.g. measured with the PIT during a power down.
+     */
+    void addElapsedTime(const uint32_t elapsed_ms);
+
+    /**
+     * @brief Marks the time as unknown until the next #sync(), e.g. after
+     * having slept for an unknown amount of time.
+     */
+    void invalidate(void);
+};
+
+extern NetworkTimeClass NetworkTime;
+
+#endif
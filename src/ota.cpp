@@ -0,0 +1,249 @@
+#include "ota_staging.h"
+#include "crc32.h"
+#include "ecc608.h"
+#include "log.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+
+// A retried block has to start at a page boundary
+static_assert(HTTP_DOWNLOAD_BLOCK_SIZE % OTA_FLASH_PAGE_SIZE == 0,
+              "The download block size has to be a multiple of the page size");
+
+OtaClass Ota = OtaClass::instance();
+
+/**
+ * @brief End of the running application in flash, i.e. the code followed by
+ * the initial values of the variables. Defined by the linker script.
+ */
+extern char __data_load_end;
+
+static OtaFlashDriver flash_driver = {NULL, NULL, NULL};
+
+static uint8_t page_buffer[OTA_FLASH_PAGE_SIZE];
+static uint32_t page_offset = 0;
+static uint16_t page_fill   = 0;
+static bool flash_failed    = false;
+
+static bool has_staged_image       = false;
+static OtaStagedImage staged_image = {};
+static OtaStatistics statistics    = {};
+
+/**
+ * @brief Erases the page in the staging area and writes the buffered page to
+ * it. The page is always erased first, as it might have been written before
+ * if the download was resumed or a block retried.
+ */
+static void writePage(void) {
+
+    const uint32_t address  = OTA_STAGING_ADDRESS + page_offset;
+    const uint32_t start_ms = millis();
+
+    // Pad a partial last page with what erased flash reads as
+    memset(&page_buffer[page_fill], 0xFF, OTA_FLASH_PAGE_SIZE - page_fill);
+
+    if (!flash_driver.erasePage(address) ||
+        !flash_driver.write(address, page_buffer, OTA_FLASH_PAGE_SIZE)) {
+        Log.errorf(F("Failed to write flash page at 0x%lX\r\n"), address);
+        flash_failed = true;
+    }
+
+    statistics.flash_write_ms += millis() - start_ms;
+    statistics.pages_written++;
+}
+
+/**
+ * @brief Collects the image into whole pages, which are written to flash as
+ * they fill up.
+ */
+static void imageSink(const uint8_t* data,
+                      const uint16_t length,
+                      const uint32_t offset) {
+
+    uint16_t position = 0;
+
+    // A retried block starts over at a block boundary, which is page aligned
+    if (offset != page_offset + page_fill) {
+        page_offset = offset - (offset % OTA_FLASH_PAGE_SIZE);
+        page_fill   = offset % OTA_FLASH_PAGE_SIZE;
+    }
+
+    while (position < length && !flash_failed) {
+        const uint16_t amount = min(
+            (uint16_t)(length - position),
+            (uint16_t)(OTA_FLASH_PAGE_SIZE - page_fill));
+
+        memcpy(&page_buffer[page_fill], &data[position], amount);
+        page_fill += amount;
+        position += amount;
+
+        if (page_fill == OTA_FLASH_PAGE_SIZE) {
+            writePage();
+            page_offset += OTA_FLASH_PAGE_SIZE;
+            page_fill = 0;
+        }
+    }
+}
+
+/**
+ * @return The CRC-32 of @p size bytes of the staging area, read back from
+ * flash.
+ */
+static uint32_t stagedImageCrc32(const uint32_t size) {
+
+    uint32_t crc = CRC32_INITIAL_VALUE;
+    uint8_t buffer[64];
+
+    for (uint32_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        const uint16_t length = min(size - offset, (uint32_t)sizeof(buffer));
+
+        for (uint16_t i = 0; i < length; i++) {
+            buffer[i] = pgm_read_byte_far(OTA_STAGING_ADDRESS + offset + i);
+        }
+
+        crc = crc32Update(crc, buffer, length);
+    }
+
+    return ~crc;
+}
+
+void OtaClass::setFlashDriver(const OtaFlashDriver& driver) {
+    flash_driver = driver;
+}
+
+OtaResult OtaClass::stage(const char* endpoint,
+                          const HttpDownloadImage& image,
+                          const uint8_t* signature,
+                          const uint8_t* public_key) {
+
+    const uint32_t start_ms = millis();
+
+    memset(&statistics, 0, sizeof(statistics));
+    has_staged_image = false;
+
+    if (image.size > OTA_MAX_IMAGE_SIZE) {
+        return OtaResult::IMAGE_TOO_LARGE;
+    }
+
+    if (!image.verify_sha256) {
+        Log.error(F("The SHA-256 of the image is needed to verify it"));
+        return OtaResult::VERIFICATION_FAILED;
+    }
+
+    const uint32_t application_end = pgm_get_far_address(__data_load_end);
+
+    if (application_end > OTA_STAGING_ADDRESS) {
+        Log.errorf(F("The application ends at 0x%lX, within the staging area "
+                     "at 0x%lX\r\n"),
+                   application_end,
+                   OTA_STAGING_ADDRESS);
+        return OtaResult::APPLICATION_TOO_LARGE;
+    }
+
+    if (flash_driver.checkWritable == NULL) {
+        Log.error(F("No flash driver has been set, call Ota.begin()"));
+        return OtaResult::FLASH_ERROR;
+    }
+
+    if (!flash_driver.checkWritable()) {
+        Log.error(F("The flash is not writable, enable writing it from the "
+                    "application"));
+        return OtaResult::FLASH_ERROR;
+    }
+
+    // The signature is checked against the digest in the manifest before the
+    // download, so that a forged manifest is rejected without fetching the
+    // image. The download then checks that the image matches the digest.
+    if (ECC608.begin() != ATCA_SUCCESS) {
+        return OtaResult::ECC_ERROR;
+    }
+
+    bool is_verified = false;
+
+    if (atcab_verify_extern(image.sha256,
+                            signature,
+                            public_key,
+                            &is_verified) != ATCA_SUCCESS) {
+        return OtaResult::ECC_ERROR;
+    }
+
+    if (!is_verified) {
+        Log.error(F("Signature of the firmware image is not valid"));
+        return OtaResult::VERIFICATION_FAILED;
+    }
+
+    page_offset  = 0;
+    page_fill    = 0;
+    flash_failed = false;
+
+    const HttpDownloadResult result = HttpDownload.download(endpoint,
+                                                            image,
+                                                            imageSink);
+
+    if (flash_failed) {
+        HttpDownload.clearProgress();
+        return OtaResult::FLASH_ERROR;
+    }
+
+    switch (result) {
+    case HttpDownloadResult::OK:
+        break;
+
+    case HttpDownloadResult::INTERRUPTED:
+        return OtaResult::INTERRUPTED;
+
+    case HttpDownloadResult::VERIFICATION_FAILED:
+        return OtaResult::VERIFICATION_FAILED;
+
+    case HttpDownloadResult::HASH_ERROR:
+        return OtaResult::ECC_ERROR;
+
+    default:
+        return OtaResult::DOWNLOAD_ERROR;
+    }
+
+    if (page_fill > 0) {
+        writePage();
+
+        if (flash_failed) {
+            return OtaResult::FLASH_ERROR;
+        }
+    }
+
+    // Make sure that what ended up in flash is what was downloaded
+    const uint32_t crc32 = stagedImageCrc32(image.size);
+
+    if (crc32 != HttpDownload.getCrc32()) {
+        Log.error(F("The image in flash does not match the download"));
+        return OtaResult::FLASH_ERROR;
+    }
+
+    staged_image.address = OTA_STAGING_ADDRESS;
+    staged_image.size    = image.size;
+    staged_image.crc32   = crc32;
+    has_staged_image     = true;
+
+    statistics.total_ms = millis() - start_ms;
+
+    Log.infof(F("Firmware image of %lu bytes verified in %lu ms, %lu ms of "
+                "which was spent writing %u flash pages\r\n"),
+              image.size,
+              statistics.total_ms,
+              statistics.flash_write_ms,
+              statistics.pages_written);
+
+    return OtaResult::OK;
+}
+
+bool OtaClass::getStagedImage(OtaStagedImage* image) {
+
+    if (!has_staged_image) {
+        return false;
+    }
+
+    *image = staged_image;
+
+    return true;
+}
+
+OtaStatistics OtaClass::getStatistics(void) { return statistics; }
@@ -0,0 +1,40 @@
+/**
+ * @brief Staging of over-the-air firmware images with the flash written
+ * through DxCore's Flash library, see ota_staging.h. Kept apart from the rest
+ * of the library so that only sketches including this header depend on the
+ * Flash library.
+ *
+ * Writing the flash from the application has to be enabled, either with the
+ * "Flash Writing" option of the board or with a bootloader which supports it.
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include "ota_staging.h"
+
+#include <Flash.h>
+
+inline bool otaFlashCheckWritable(void) {
+    return Flash.checkWritable() == FLASHWRITE_OK;
+}
+
+inline bool otaFlashErasePage(const uint32_t address) {
+    return Flash.erasePage(address) == FLASHWRITE_OK;
+}
+
+inline bool otaFlashWrite(const uint32_t address,
+                          const uint8_t* data,
+                          const uint16_t length) {
+    return Flash.writeBytes(address, data, length) == FLASHWRITE_OK;
+}
+
+inline void OtaClass::begin(void) {
+    static const OtaFlashDriver driver = {otaFlashCheckWritable,
+                                          otaFlashErasePage,
+                                          otaFlashWrite};
+
+    setFlashDriver(driver);
+}
+
+#endif
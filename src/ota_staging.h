@@ -0,0 +1,166 @@
+/**
+ * @brief Staging of over-the-air firmware images. The image is downloaded with
+ * HttpDownload straight into a staging area in the upper half of the flash,
+ * page by page, and its ECDSA signature is verified with the ECC.
+ *
+ * This is staging only. Nothing in this library installs the staged image
+ * over the running application, and no record is left for a bootloader to
+ * find it (Optiboot does not install images either). The image stays in the
+ * staging area until it is overwritten by the next OtaClass::stage(), and
+ * OtaClass::getStagedImage() gives its location for an application specific
+ * installer.
+ *
+ * The flash is written through a OtaFlashDriver. Include ota.h instead of this
+ * header to use DxCore's Flash library for it.
+ */
+
+#ifndef OTA_STAGING_H
+#define OTA_STAGING_H
+
+#include "http_download.h"
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of a flash page, which is the unit the flash is erased in.
+ */
+#define OTA_FLASH_PAGE_SIZE (512)
+
+/**
+ * @brief Start of the staging area the image is downloaded to. The upper half
+ * of the flash, so the running application can't be larger than the space
+ * left below, which is checked before anything is erased.
+ */
+#define OTA_STAGING_ADDRESS (0x10000UL)
+
+#define OTA_FLASH_END (0x20000UL)
+
+#define OTA_MAX_IMAGE_SIZE (OTA_FLASH_END - OTA_STAGING_ADDRESS)
+
+/**
+ * @brief A verified image in the staging area.
+ */
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+
+    // CRC-32 of the image as it was read back from flash
+    uint32_t crc32;
+} OtaStagedImage;
+
+enum class OtaResult {
+    OK = 0,
+
+    // The download was interrupted, calling stage() again resumes it
+    INTERRUPTED,
+
+    // The image is too large for the staging area
+    IMAGE_TOO_LARGE,
+
+    // The running application extends into the staging area, so staging the
+    // image would erase it
+    APPLICATION_TOO_LARGE,
+
+    // The signature or the hash of the image did not match
+    VERIFICATION_FAILED,
+
+    // The flash could not be written, writing it from the application is not
+    // enabled or no flash driver has been set
+    FLASH_ERROR,
+
+    // The ECC could not be used for verification
+    ECC_ERROR,
+
+    // The server could not deliver the image
+    DOWNLOAD_ERROR
+};
+
+/**
+ * @brief Writes the flash for OtaClass. ota.h provides one for DxCore's Flash
+ * library. All the functions return true on success.
+ */
+typedef struct {
+    // Whether the flash can be written from the application
+    bool (*checkWritable)(void);
+
+    // Erases the page of OTA_FLASH_PAGE_SIZE bytes at address
+    bool (*erasePage)(const uint32_t address);
+
+    // Writes length bytes of data to address, which has been erased
+    bool (*write)(const uint32_t address,
+                  const uint8_t* data,
+                  const uint16_t length);
+} OtaFlashDriver;
+
+/**
+ * @brief Time spent in the phases of the last staging.
+ */
+typedef struct {
+    uint32_t total_ms;
+    uint32_t flash_write_ms;
+    uint16_t pages_written;
+} OtaStatistics;
+
+class OtaClass {
+
+  private:
+    OtaClass(){};
+
+  public:
+    static OtaClass& instance(void) {
+        static OtaClass instance;
+        return instance;
+    }
+
+    /**
+     * @brief Sets the driver used to write the flash. Has to be done before
+     * #stage(). ota.h defines #begin() which sets the driver for DxCore's
+     * Flash library.
+     */
+    void setFlashDriver(const OtaFlashDriver& driver);
+
+    /**
+     * @brief Sets up staging with DxCore's Flash library. Only available when
+     * ota.h is included.
+     */
+    void begin(void);
+
+    /**
+     * @brief Downloads the image at @p endpoint from the host configured in
+     * HttpClient into the staging area and verifies it. The signature is
+     * checked before the download starts, and the SHA-256 of the downloaded
+     * image is checked against the signed digest afterwards. An interrupted
+     * download is resumed when called again with the same image. Will block
+     * until done.
+     *
+     * Nothing is erased if the running application extends into the staging
+     * area.
+     *
+     * @param endpoint The part of the URL after the host name.
+     * @param image Size and SHA-256 digest of the image, typically from a
+     * manifest. The SHA-256 is always verified.
+     * @param signature ECDSA P-256 signature of the SHA-256 digest, R and S
+     * concatenated (64 bytes).
+     * @param public_key Public key of the signer, X and Y concatenated (64
+     * bytes).
+     */
+    OtaResult stage(const char* endpoint,
+                    const HttpDownloadImage& image,
+                    const uint8_t* signature,
+                    const uint8_t* public_key);
+
+    /**
+     * @brief Retrieves the image verified by the last successful #stage(),
+     * e.g. for handing it over to an installer. Not kept across a reset.
+     *
+     * @return false if there is no verified image.
+     */
+    bool getStagedImage(OtaStagedImage* image);
+
+    OtaStatistics getStatistics(void);
+};
+
+extern OtaClass Ota;
+
+#endif
@@ -18,6 +18,12 @@ BOARD_CONFIG = "DxCore:megaavr:avrdb:appspm=no,chip=avr128db48,clock=24internal,
     "bodvoltage=1v9,bodmode=disabled,eesave=enable,resetpin=reset,"\
     "millis=tcb2,startuptime=8,wiremode=mors2,printf=full"
 
+# Examples which need a different board configuration. The OTA example writes
+# the flash from the application.
+EXAMPLE_BOARD_CONFIG = {
+    "ota": BOARD_CONFIG.replace("appspm=no", "appspm=unrestricted")
+}
+
 SERIAL_TIMEOUT = 30
 
 
@@ -230,6 +236,56 @@ def example_test_data():
                 "expectation": "\\[INFO\\] Body: {"
             }
         ],
+        "http_download": [
+            {
+                "expectation": "\\[INFO\\] Starting HTTP download example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Downloaded and verified 40960 bytes in \\d+ ms, CRC-32 DB0C89C1",
+                "timeout": 180
+            }
+        ],
+        "http_spool": [
+            {
+                "expectation": "\\[INFO\\] Starting HTTP spool example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "repeat": 3,
+                "expectation": "\\[INFO\\] Posted 7 records in one request, status code: 200"
+            }
+        ],
+        "http_stream_download": [
+            {
+                "expectation": "\\[INFO\\] Starting HTTP stream download example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] GET - HTTP status code: 200, data size: 8192"
+            },
+            {
+                "expectation": "\\[INFO\\] Downloaded 8192 bytes in \\d+ ms \\(request \\d+ ms\\), \\d+ B/s, checksum \\d+"
+            }
+        ],
         "http_get_time": [
             {
                 "expectation": "\\[INFO\\] Starting HTTP Get Time Example"
@@ -243,6 +299,9 @@ def example_test_data():
             {
                 "expectation": "\\[INFO\\] Connected to operator: (.*)"
             },
+            {
+                "expectation": "\\[INFO\\] Got the network time \\(unixtime\\) (\\d{10})"
+            },
             {
                 "expectation": "\\[INFO\\] --- Configured to HTTP ---"
             },
@@ -251,6 +310,9 @@ def example_test_data():
             },
             {
                 "expectation": "\\[INFO\\] Got the time \\(unixtime\\) (\\d{10})"
+            },
+            {
+                "expectation": "\\[INFO\\] The network time differs by (-?\\d{1,2}) seconds"
             }
         ],
         "https": [
@@ -300,6 +362,92 @@ def example_test_data():
                 "expectation": "\\[INFO\\] Response: {"
             }
         ],
+        "inflate_benchmark": [
+            {
+                "expectation": "\\[INFO\\] Starting inflate benchmark"
+            },
+            {
+                "expectation": "BENCH,window_bits,compressed_size,inflated_size,count,ms_per_inflate,inflated_kb_per_s,peak_ram_bytes"
+            },
+            {
+                "repeat": 4,
+                "timeout": 60,
+                "expectation": "BENCH,\\d+,\\d+,6439,10,\\d+,\\d+\\.\\d{2},\\d+"
+            },
+            {
+                "expectation": "\\[INFO\\] Benchmark done"
+            }
+        ],
+        "lte_async": [
+            {
+                "expectation": "\\[INFO\\] Starting LTE async example"
+            },
+            {
+                "expectation": "\\[INFO\\] LTE state: SIM_CHECK"
+            },
+            {
+                "expectation": "\\[INFO\\] LTE state: REGISTERING"
+            },
+            {
+                "expectation": "\\[INFO\\] LTE state: TIME_SYNC",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] LTE state: CONNECTED",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected after \\d+ ms, the loop ran \\d+ times whilst connecting"
+            }
+        ],
+        "lte_cell_cache": [
+            {
+                "expectation": "\\[INFO\\] Starting LTE cell cache example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Cached cell on PLMN \\d{5,6}, band \\d+, EARFCN \\d+"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Attaches: 2, cached: 1, fallbacks: 0",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Full scan attach took \\d+ ms, cached attach took \\d+ ms"
+            }
+        ],
+        "lte_signal": [
+            {
+                "expectation": "\\[INFO\\] Starting LTE signal example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "repeat": 5,
+                "expectation": "\\[INFO\\] RSRP: -?\\d+ dBm, RSRQ: -?\\d+ dB, SINR: -?\\d+ dB, cell ID: \\d+"
+            },
+            {
+                "expectation": "\\[INFO\\] Average RSRP of 5 samples: -?\\d+ dBm, good time to transmit: (yes|no)"
+            }
+        ],
         "mqtt_aws": [
             {
                 "expectation": "\\[INFO\\] Starting MQTT for AWS example"
@@ -370,6 +518,28 @@ def example_test_data():
                 "expectation": "\\[INFO\\] Closing MQTT connection"
             }
         ],
+        "mqtt_benchmark": [
+            {
+                "expectation": "\\[INFO\\] Starting MQTT benchmark"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to MQTT broker.{0,}OK!"
+            },
+            {
+                "expectation": "BENCH,path,qos,size,count,msgs_per_s,publish_p50_ms,publish_p90_ms,publish_max_ms,roundtrip_p50_ms,read_p50_ms"
+            },
+            {
+                "repeat": 21,
+                "timeout": 300,
+                "expectation": "BENCH,(sync|async),[0-2],\\d+,\\d+,\\d+\\.\\d{2}(,\\d+){5}"
+            },
+            {
+                "expectation": "\\[INFO\\] Benchmark done"
+            }
+        ],
         "mqtt_custom_broker": [
             {
                 "expectation": "\\[INFO\\] Starting MQTT with custom broker"
@@ -497,6 +667,38 @@ def example_test_data():
                 "expectation": "\\[INFO\\] Closing MQTT connection"
             }
         ],
+        "mqtt_qos2": [
+            {
+                "expectation": "\\[INFO\\] Starting MQTT QoS 2 example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to MQTT broker.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Published message 0, delivery state: PUBLISHED"
+            },
+            {
+                "expectation": "\\[INFO\\] Received message 0, delivery state: DELIVERED"
+            },
+            {
+                "expectation": "\\[INFO\\] Published message 1, delivery state: PUBLISHED"
+            },
+            {
+                "expectation": "\\[INFO\\] Received message 1, delivery state: DELIVERED"
+            },
+            {
+                "expectation": "\\[INFO\\] Published message 2, delivery state: PUBLISHED"
+            },
+            {
+                "expectation": "\\[INFO\\] Received message 2, delivery state: DELIVERED"
+            },
+            {
+                "expectation": "\\[INFO\\] Received 3 of 3 messages, 0 duplicates"
+            }
+        ],
         "mqtt_with_connection_loss_handling": [
             {
                 "expectation": "\\[INFO\\] Starting MQTT with Connection Loss Handling"
@@ -521,6 +723,25 @@ def example_test_data():
                 "expectation": "\\[INFO\\] Published message: \\d{1,}. Failed publishes: \\d{1,}."
             },
         ],
+        "ota": [
+            {
+                "expectation": "\\[INFO\\] Starting OTA example"
+            },
+            {
+                "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
+            },
+            {
+                "expectation": "\\[INFO\\] Connected to operator: (.*)",
+                "timeout": 60
+            },
+            {
+                "expectation": "\\[INFO\\] Firmware image of 16384 bytes verified in \\d+ ms, \\d+ ms of which was spent writing 32 flash pages",
+                "timeout": 120
+            },
+            {
+                "expectation": "\\[INFO\\] Staged image of 16384 bytes at 0x10000, CRC-32 4AA39D4A"
+            }
+        ],
         "power_down": [
             {
                 "expectation": "\\[INFO\\] Connecting to operator.{0,}OK!"
@@ -686,11 +907,13 @@ def program(request, backend):
 
     sketch_path = Path(f"{sketch_directory}/{example_name}/{example_name}.ino")
 
+    board_config = EXAMPLE_BOARD_CONFIG.get(example_name, BOARD_CONFIG)
+
     if not build_directory.exists():
         os.mkdir(build_directory)
 
     compilation_return_code = subprocess.run(
-        ["arduino-cli", "compile", f"{sketch_path}", "-b", f"{BOARD_CONFIG}", "--build-path", f"{build_directory}", "--warnings", "all"], shell=True).returncode
+        ["arduino-cli", "compile", f"{sketch_path}", "-b", f"{board_config}", "--build-path", f"{build_directory}", "--warnings", "all"], shell=True).returncode
 
     assert compilation_return_code == 0, f"{example_name} failed to compile, return code: {compilation_return_code}"
 
@@ -795,10 +1018,22 @@ def test_http(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_http_download(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_http_get_time(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_http_spool(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
+def test_http_stream_download(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_https(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
@@ -807,6 +1042,22 @@ def test_https_with_header(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_inflate_benchmark(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
+def test_lte_async(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
+def test_lte_cell_cache(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
+def test_lte_signal(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_mqtt_aws(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
@@ -815,6 +1066,10 @@ def test_mqtt_azure(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_mqtt_benchmark(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_mqtt_custom_broker(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
@@ -827,10 +1082,18 @@ def test_mqtt_password_authentication(request, backend, session_config, example_
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_mqtt_qos2(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_mqtt_with_connection_loss_handling(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 
 
+def test_ota(request, backend, session_config, example_test_data):
+    run_test(request, backend, session_config, example_test_data)
+
+
 def test_power_down(request, backend, session_config, example_test_data):
     run_test(request, backend, session_config, example_test_data)
 